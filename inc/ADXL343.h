@@ -3,6 +3,7 @@
 
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "hardware/spi.h"
 
 /*
 ADCL343 defines are taken from the Adafruit library
@@ -49,6 +50,45 @@ https://github.com/adafruit/Adafruit_ADXL343/blob/master/Adafruit_ADXL343.h
 #define ADXL3XX_RANGE_8G            (0x02)
 #define ADXL3XX_RANGE_16G           (0x03)
 
+// Output data rate options for the ADXL3XX (Used in the ADXL3XX_REG_BW_RATE register)
+#define ADXL3XX_DATARATE_3200_HZ    (0x0F)
+#define ADXL3XX_DATARATE_1600_HZ    (0x0E)
+#define ADXL3XX_DATARATE_800_HZ     (0x0D)
+#define ADXL3XX_DATARATE_400_HZ     (0x0C)
+#define ADXL3XX_DATARATE_200_HZ     (0x0B)
+#define ADXL3XX_DATARATE_100_HZ     (0x0A)  /**< Power on default */
+#define ADXL3XX_DATARATE_50_HZ      (0x09)
+#define ADXL3XX_DATARATE_25_HZ      (0x08)
+#define ADXL3XX_DATARATE_12_5_HZ    (0x07)
+#define ADXL3XX_DATARATE_6_25_HZ    (0x06)
+#define ADXL3XX_LOW_POWER           (0x10)  /**< Or-ed with a data rate up to 400Hz, less current for more noise */
+
+// Activity and inactivity detection (Used in the ADXL3XX_REG_ACT_INACT_CTL register)
+#define ADXL3XX_ACT_AC              (0x80)  /**< Activity is measured against the acceleration when detection started */
+#define ADXL3XX_ACT_XYZ             (0x70)  /**< Activity on any axis counts */
+#define ADXL3XX_INACT_AC            (0x08)  /**< Inactivity is measured against a reference that follows the wand */
+#define ADXL3XX_INACT_XYZ           (0x07)  /**< Inactivity has to be on every axis */
+#define ADXL3XX_ACT_THRESH_MG       62.5    /**< Scale of THRESH_ACT and THRESH_INACT, in mg per LSB */
+
+// Interrupt sources (Used in the ADXL3XX_REG_INT_ENABLE, INT_MAP and INT_SOURCE registers)
+#define ADXL3XX_INT_DATA_READY      (0x80)
+#define ADXL3XX_INT_SINGLE_TAP      (0x40)
+#define ADXL3XX_INT_DOUBLE_TAP      (0x20)
+#define ADXL3XX_INT_ACTIVITY        (0x10)
+#define ADXL3XX_INT_INACTIVITY      (0x08)
+#define ADXL3XX_INT_FREE_FALL       (0x04)
+#define ADXL3XX_INT_WATERMARK       (0x02)
+#define ADXL3XX_INT_OVERRUN         (0x01)
+
+// FIFO modes (Used in the ADXL3XX_REG_FIFO_CTL register)
+#define ADXL3XX_FIFO_MODE_BYPASS    (0x00)  /**< Power on default, no FIFO */
+#define ADXL3XX_FIFO_MODE_FIFO      (0x40)  /**< Collects samples until full, then stops */
+#define ADXL3XX_FIFO_MODE_STREAM    (0x80)  /**< Collects samples, dropping the oldest when full */
+#define ADXL3XX_FIFO_MODE_TRIGGER   (0xC0)  /**< Keeps a history of samples until the trigger interrupt fires */
+#define ADXL3XX_FIFO_TRIGGER_INT2   (0x20)  /**< Trigger mode is triggered by INT2 instead of INT1 */
+#define ADXL3XX_FIFO_SIZE           33      /**< Entries available, 32 in the FIFO plus the data registers */
+#define ADXL3XX_FIFO_SAMPLES_MAX    31      /**< Largest watermark, the samples field of FIFO_CTL is 5 bits */
+
 // The selected range for the ADXL343
 #define SELECTED_ADXL3XX_RANGE      ADXL3XX_RANGE_16G   
 
@@ -72,15 +112,65 @@ https://github.com/adafruit/Adafruit_ADXL343/blob/master/Adafruit_ADXL343.h
 
 #define ADXL343_I2C_TIMEOUT_US  5 * 1000 * 1000 // 5 second timeout      
 
+// i2c bus speeds. The ADXL343 is specified up to fast mode, the RP2040 will go up to fast mode plus
+#define ADXL343_I2C_STANDARD_MODE_HZ    (100 * 1000)
+#define ADXL343_I2C_FAST_MODE_HZ        (400 * 1000)
+#define ADXL343_I2C_FAST_MODE_PLUS_HZ   (1000 * 1000)
+
+// 4-wire SPI. The ADXL343 is specified up to 5MHz, which reads a FIFO entry in a fraction of the time fast mode i2c takes
+#define ADXL343_SPI_MAX_HZ      (5 * 1000 * 1000)
+#define ADXL343_SPI_READ        (0x80)  /**< Set in the address byte of a read */
+#define ADXL343_SPI_MULTI_BYTE  (0x40)  /**< Set in the address byte of a burst, so the address increments */
+
+/*
+Bus the adxl343 is reached over. Everything above register access (adxl343_read_registers and
+adxl343_write_register) is the same whatever the bus, multi-byte bursts included.
+
+    ADXL343_BUS_I2C     i2c at address, the wand as built
+    ADXL343_BUS_SPI     4-wire SPI, with a chip select driven by hand so it stays low for a whole burst
+    ADXL343_BUS_MOCK    a register file in RAM (see adxl343_mock), to run the driver on the host
+*/
+typedef enum adxl343_bus_enum {
+    ADXL343_BUS_I2C,
+    ADXL343_BUS_SPI,
+    ADXL343_BUS_MOCK
+} adxl343_bus;
+
+// one reading of all three axes, in raw counts
+typedef struct adxl343_xyz_struct {
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} adxl343_xyz;
+
+/*
+Stand-in for the device, for the mock bus
+Registers keep whatever is written to them, and read back the device ID. Pushed samples show up in the data
+registers and, outside of bypass mode, queue up in a FIFO that reading DATAZ1 pops, as the end of a burst read of
+the data registers does on the device. FIFO_STATUS counts the queued samples.
+*/
+typedef struct adxl343_mock_struct {
+    uint8_t regs[ADXL3XX_REG_FIFO_STATUS + 1];
+    adxl343_xyz fifo[ADXL3XX_FIFO_SIZE];
+    uint8_t head;           // oldest sample in fifo, the one in the data registers
+    uint8_t n;              // samples in fifo
+    uint32_t reads;         // read transactions, each one burst however long
+    uint32_t writes;        // write transactions
+} adxl343_mock;
+
 // adxl343 struct
 typedef struct adxl343_struct {
-    uint8_t address;
+    adxl343_bus bus;
+    uint8_t address;        // i2c
     i2c_inst_t *i2c;
+    spi_inst_t *spi;        // SPI
+    uint cs_pin;
+    adxl343_mock *mock;     // mock
 } adxl343;
 
 
 /*
-Sets up the i2c used to communicate to the adxl343, and configures
+Sets up the i2c used to communicate to the adxl343 at baudrate (Hz), and configures
 the device for usage
 
 Returns:
@@ -89,23 +179,103 @@ Returns:
     PICO_ERROR_GENERIC: adxl343 did not respond with the expected device ID of 0xe5
 
 */
-int adxl343_setup(adxl343 *accelerometer, i2c_inst_t *i2c, uint8_t SDA_pin, uint8_t SCL_pin, uint8_t address);
+int adxl343_setup(adxl343 *accelerometer, i2c_inst_t *i2c, uint8_t SDA_pin, uint8_t SCL_pin, uint8_t address, uint baudrate);
+
+/*
+Sets up the SPI used to communicate to the adxl343 at baudrate (Hz, at most ADXL343_SPI_MAX_HZ) and its chip select
+pin, and configures the device for usage
+
+Returns:
+    PICO_ERROR_NONE: success
+    PICO_ERROR_GENERIC: adxl343 did not respond with the expected device ID of 0xe5
+*/
+int adxl343_setup_spi(adxl343 *accelerometer, spi_inst_t *spi, uint8_t SCK_pin, uint8_t MOSI_pin, uint8_t MISO_pin,
+                      uint8_t CS_pin, uint baudrate);
+
+/*
+Empties the mock's FIFO, and puts its registers in their power-on state
+*/
+void adxl343_mock_init(adxl343_mock *mock);
+
+/*
+Hands a new sample to the mock, as if the device had just measured it
+*/
+void adxl343_mock_push(adxl343_mock *mock, const adxl343_xyz *sample);
+
+/*
+Talks to mock instead of a device, and configures it for usage like the other setups. Returns the same errors
+*/
+int adxl343_setup_mock(adxl343 *accelerometer, adxl343_mock *mock);
 
 /*
-Writes a register on the adxl343. Returns i2c errors if encountered
+Writes a register on the adxl343. Returns bus errors if encountered
 */
 int adxl343_write_register(adxl343 *accelerometer, uint8_t reg, uint8_t value);
 
 /*
-Reads 8 bits from a register on the adxl343. Returns i2c errors if encountered
+Reads 8 bits from a register on the adxl343. Returns bus errors if encountered
 */
 int adxl343_read_register_8(adxl343 *accelerometer, uint8_t reg, uint8_t *out_val);
 
 /*
-Reads 16 bits from a register on the adxl343. Returns i2c errors if encountered
+Reads 16 bits from a register on the adxl343. Returns bus errors if encountered
 */
 int adxl343_read_register_16(adxl343 *accelerometer, uint8_t reg, int16_t *out_val);
 
+/*
+Selects the output data rate of the adxl343, one of the ADXL3XX_DATARATE_ values, optionally or-ed with
+ADXL3XX_LOW_POWER. Returns bus errors if encountered
+*/
+int adxl343_set_data_rate(adxl343 *accelerometer, uint8_t data_rate);
+
+/*
+Enables the interrupt sources in int_enable (ADXL3XX_INT_ bits). Sources with their bit set in int2_map are
+routed to the INT2 pin, and the rest to INT1. The pins are active high. Returns bus errors if encountered
+*/
+int adxl343_set_interrupts(adxl343 *accelerometer, uint8_t int_enable, uint8_t int2_map);
+
+/*
+Sets up activity and inactivity detection on every axis, ac-coupled so gravity doesn't count. Activity is a change
+of more than act_thresh, and inactivity less than inact_thresh for inact_time_s seconds (thresholds in units of
+ADXL3XX_ACT_THRESH_MG). Enable the ACTIVITY and INACTIVITY interrupts to be told. Returns bus errors if encountered
+*/
+int adxl343_set_activity(adxl343 *accelerometer, uint8_t act_thresh, uint8_t inact_thresh, uint8_t inact_time_s);
+
+/*
+Reads which interrupt sources have fired (ADXL3XX_INT_ bits), which clears the latched ones such as ACTIVITY and
+INACTIVITY. Returns bus errors if encountered
+*/
+int adxl343_get_int_source(adxl343 *accelerometer, uint8_t *source);
+
+/*
+Configures the FIFO. mode is one of the ADXL3XX_FIFO_MODE_ values, optionally or-ed with ADXL3XX_FIFO_TRIGGER_INT2.
+In FIFO and stream mode, the WATERMARK interrupt fires once 'samples' entries are held. In trigger mode, 'samples'
+is how many entries of history from before the trigger event are kept, at most ADXL3XX_FIFO_SAMPLES_MAX
+
+Returns:
+    PICO_ERROR_GENERIC: samples doesn't fit into FIFO_CTL
+    bus errors if encountered
+*/
+int adxl343_set_fifo(adxl343 *accelerometer, uint8_t mode, uint8_t samples);
+
+/*
+Reads the number of entries held in the FIFO, and whether the trigger event has happened in trigger mode.
+triggered may be NULL. Returns bus errors if encountered
+*/
+int adxl343_get_fifo_status(adxl343 *accelerometer, uint8_t *entries, bool *triggered);
+
+/*
+Drains up to max_samples entries from the FIFO into out_vals, oldest first, one 6 byte burst per entry.
+n_read is set to the number of entries read. Returns bus errors if encountered
+*/
+int adxl343_read_fifo(adxl343 *accelerometer, adxl343_xyz *out_vals, size_t max_samples, size_t *n_read);
+
+/*
+Reads len consecutive registers starting at reg in a single transaction on the bus. Returns the number of bytes read,
+or bus errors if encountered
+*/
+int adxl343_read_registers(adxl343 *accelerometer, uint8_t reg, uint8_t *out_vals, size_t len);
+
 /*
 Gets the most recent x axis value
 */
@@ -121,5 +291,11 @@ Gets the most recent z axis value
 */
 int adxl343_getz(adxl343 *accelerometer, int16_t *out_val);
 
+/*
+Gets the most recent value of all three axes, in one 6 byte burst read of DATAX0 through DATAZ1.
+Reading the axes together also guarantees they come from the same sample.
+*/
+int adxl343_read_xyz(adxl343 *accelerometer, adxl343_xyz *out_vals);
+
 
 #endif
\ No newline at end of file
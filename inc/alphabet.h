@@ -1,46 +0,0 @@
-
-/*
-Generated by scripts/generate_alphabet.py
-
-This h file contains generated representations for characters to be dispalyed on the light wand as arrays of 32-bit integers
-Each 32-bit integer in an array is a column of the characer, and each bit in that integer is a pixel. 1's mean on, 0's mean off.
-
-The lowest pixel on the wand is the LSB
-
-*/
-
-#include <stdint.h>
-
-#define CHAR_WIDTH      15
-#define CHAR_HEIGHT     15
-
-const uint32_t CHAR_A[CHAR_WIDTH]       = {0x00000000,0x00004000,0x00007800,0x00007f00,0x00003fe0,0x00000ffc,0x00000e7f,0x00000e1f,0x00000eff,0x00000ffc,0x00007fe0,0x00007f00,0x00007000,0x00000000,0x00000000};
-const uint32_t CHAR_B[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00007fff,0x00007fff,0x00007fff,0x000061c7,0x000060c3,0x000060c3,0x000060c7,0x000071e7,0x00007ffe,0x00003f7e,0x00001e18,0x00000000,0x00000000};
-const uint32_t CHAR_C[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000ff8,0x00003ffc,0x00003ffe,0x00007007,0x00006003,0x00006003,0x00006003,0x00007007,0x00003c1e,0x00001c1c,0x00000810,0x00000000,0x00000000};
-const uint32_t CHAR_D[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00007fff,0x00007fff,0x00007fff,0x00006007,0x00006003,0x00007007,0x00007007,0x00003c1e,0x00001ffc,0x00000ff8,0x000003e0,0x00000000,0x00000000};
-const uint32_t CHAR_E[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00007ffe,0x00007fff,0x00007fff,0x000071c7,0x000060c3,0x000060c3,0x000060c3,0x000060c3,0x000060c3,0x00006083,0x00006002,0x00000000,0x00000000};
-const uint32_t CHAR_F[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000000,0x00007fff,0x00007fff,0x000001c7,0x000001c3,0x000001c3,0x000001c3,0x000001c3,0x000001c3,0x00000183,0x00000003,0x00000000,0x00000000};
-const uint32_t CHAR_G[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000ff8,0x00003ffc,0x00003ffe,0x00007007,0x00006003,0x00006103,0x00006383,0x00007387,0x00007f9e,0x00003f9c,0x00001f00,0x00000000,0x00000000};
-const uint32_t CHAR_H[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00007fff,0x00007fff,0x00007fff,0x000001c0,0x000001c0,0x000001c0,0x000001c0,0x00007fff,0x00007fff,0x00007fff,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_I[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000000,0x00006003,0x00006003,0x00006007,0x00007fff,0x00007fff,0x00007fff,0x00006003,0x00006003,0x00006003,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_J[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00001800,0x00003800,0x00007800,0x00007000,0x00006000,0x00006000,0x00007000,0x00007fff,0x00003fff,0x00001fff,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_K[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00007fff,0x00007fff,0x00007fff,0x000003c0,0x000001e0,0x000003f0,0x00000ffc,0x00001f3e,0x00007c0f,0x00007807,0x00006003,0x00004000,0x00000000};
-const uint32_t CHAR_L[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000000,0x00007fff,0x00007fff,0x00007000,0x00006000,0x00006000,0x00006000,0x00006000,0x00006000,0x00006000,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_M[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00007fff,0x00007fff,0x00007fff,0x0000003f,0x000003f8,0x000003e0,0x000000fe,0x0000001f,0x00007fff,0x00007fff,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_N[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00007fff,0x00007fff,0x00007fff,0x0000007e,0x000000f8,0x000007c0,0x00001f00,0x00007fff,0x00007fff,0x00007fff,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_O[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000ff8,0x00003ffe,0x00003ffe,0x00007007,0x00006003,0x00006003,0x00007007,0x0000780f,0x00003ffe,0x00001ffc,0x000007f0,0x00000000,0x00000000};
-const uint32_t CHAR_P[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000000,0x00007fff,0x00007fff,0x00000387,0x00000383,0x00000383,0x00000187,0x000001c7,0x000001fe,0x000000fe,0x00000078,0x00000000,0x00000000};
-const uint32_t CHAR_Q[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000ff8,0x00003ffe,0x00003ffe,0x00007007,0x00006003,0x00006003,0x00007007,0x0000780f,0x00007ffe,0x00005ffc,0x000007f0,0x00000000,0x00000000};
-const uint32_t CHAR_R[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00007fff,0x00007fff,0x00007fff,0x00000387,0x00000183,0x00000383,0x00000f87,0x00003fc7,0x00007ffe,0x000078fe,0x00006038,0x00000000,0x00000000};
-const uint32_t CHAR_S[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00001c18,0x00003c7e,0x00003cfe,0x000070e7,0x000060c3,0x000061c3,0x000061c3,0x00007387,0x00007f8e,0x00003f0e,0x00001e08,0x00000000,0x00000000};
-const uint32_t CHAR_T[CHAR_WIDTH]       = {0x00000000,0x00000003,0x00000003,0x00000003,0x00000003,0x00000007,0x00007fff,0x00007fff,0x00007fff,0x00000003,0x00000003,0x00000003,0x00000003,0x00000000,0x00000000};
-const uint32_t CHAR_U[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000fff,0x00003fff,0x00003fff,0x00007000,0x00006000,0x00006000,0x00007000,0x00007fff,0x00003fff,0x00001fff,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_V[CHAR_WIDTH]       = {0x00000000,0x00000001,0x0000000f,0x0000007f,0x000007ff,0x00003ff0,0x00007f00,0x00007c00,0x00007fc0,0x00001ffc,0x000001ff,0x0000003f,0x00000007,0x00000000,0x00000000};
-const uint32_t CHAR_W[CHAR_WIDTH]       = {0x00000000,0x00000003,0x000001ff,0x00007fff,0x00007fe0,0x00007fe0,0x000007ff,0x000000ff,0x00003ffe,0x00007f80,0x00007ffc,0x00003fff,0x0000003f,0x00000000,0x00000000};
-const uint32_t CHAR_X[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00006003,0x0000780f,0x00007e3f,0x00001ffc,0x000007f0,0x000003e0,0x00000ff8,0x00003f7e,0x00007c1f,0x00007807,0x00006003,0x00000000,0x00000000};
-const uint32_t CHAR_Y[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00000003,0x0000001f,0x0000007f,0x000001fc,0x00007fe0,0x00007fc0,0x00007ff0,0x000000fc,0x0000003f,0x0000000f,0x00000003,0x00000000,0x00000000};
-const uint32_t CHAR_Z[CHAR_WIDTH]       = {0x00000000,0x00000000,0x00007003,0x00007803,0x00007e03,0x00007f03,0x000067c3,0x000063e3,0x000060fb,0x0000607f,0x0000601f,0x0000600f,0x00006003,0x00000000,0x00000000};
-const uint32_t CHAR_BANG[CHAR_WIDTH]    = {0x00000000,0x00000000,0x00000000,0x00000000,0x00000000,0x00000000,0x000073ff,0x000073ff,0x000061ff,0x00000000,0x00000000,0x00000000,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_QUESTION[CHAR_WIDTH]        = {0x00000000,0x00000000,0x00000000,0x0000000e,0x0000000e,0x0000000f,0x00007303,0x00007383,0x000073c3,0x000000ff,0x0000007e,0x0000003e,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_PERIOD[CHAR_WIDTH]  = {0x00000000,0x00000000,0x00000000,0x00000000,0x00000000,0x00002000,0x00007000,0x00007800,0x00007000,0x00000000,0x00000000,0x00000000,0x00000000,0x00000000,0x00000000};
-const uint32_t CHAR_COMMA[CHAR_WIDTH]   = {0x00000000,0x00000000,0x00000000,0x00000000,0x00000000,0x00000000,0x00006000,0x00006000,0x00000000,0x00000000,0x00000000,0x00000000,0x00000000,0x00000000,0x00000000};
\ No newline at end of file
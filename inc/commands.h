@@ -0,0 +1,52 @@
+/*
+USB serial command channel for changing what the wand displays while it runs
+
+Commands are single lines of text, answered with "OK" or "ERR <reason>":
+
+    MSG <text>          display text (up to POV_MAX_TEXT_LEN characters). Text too long for the display scrolls
+    SCALE <n>           repeat every character column n times
+    SCROLL <n>          columns text too long for the display scrolls on per swing, 0 to reject it instead
+    FG <r> <g> <b> <w>  colour of the characters, each channel 0-255
+    BG <r> <g> <b> <w>  colour of the background
+    IMG <name>          display one of the built in images (see inc/image.h) instead of the text, until the text
+                        is changed again
+    GET                 print the current settings
+    STATS               print how many swings had to be shown at a lower resolution, and how many were cut short,
+                        then the samples read, and the errors reading them (see inc/sampler.h)
+    TRACE               print the trace counters, and drain the events recorded since the last dump (see inc/trace.h)
+    TRACE CLEAR         throw the recorded events away, and clear the counters
+
+Every accepted change starts a background render of the new content, which is swapped in at a swing boundary.
+*/
+#ifndef COMMANDSH
+#define COMMANDSH
+
+#include "pico/stdlib.h"
+
+#include "pov.h"
+
+#define COMMAND_MAX_LEN         (POV_MAX_TEXT_LEN + 8)
+
+// a partially received command line
+typedef struct command_reader_struct {
+    char line[COMMAND_MAX_LEN + 1];
+    int len;
+    bool overflowed;
+} command_reader;
+
+
+void command_reader_init(command_reader *reader);
+
+/*
+Reads whatever has arrived over USB without blocking
+Returns a complete command line, or NULL if there isn't one yet. The line stays valid until the next call.
+*/
+const char *command_poll(command_reader *reader);
+
+/*
+Carries out a command line, starting a new render on renderer if the content changed, and prints the reply
+Returns -1 if the command was rejected
+*/
+int command_execute(const char *line, pov_renderer *renderer);
+
+#endif
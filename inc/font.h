@@ -0,0 +1,59 @@
+/*
+Proportional font atlas for the light wand
+
+Glyphs are FONT_HEIGHT pixels tall and as wide as their ink, so the columns of every glyph are packed back to back
+into font_columns, one 16-bit column each. Bit 0 of a column is the lowest pixel on the wand as it is held.
+Every printable ASCII character is in the atlas, and a few more characters can be added as extras, found from their
+unicode code point.
+
+src/font_atlas.c is generated by scripts/generate_alphabet.py. It is checked in, and regenerated by the build when
+LIGHT_WAND_FONT is set (see CMakeLists.txt). The counts below must match the generated atlas.
+*/
+#ifndef FONTH
+#define FONTH
+
+#include "pico/stdlib.h"
+
+#define FONT_HEIGHT         15
+#define FONT_SPACING        1       // blank columns between glyphs, before scaling
+
+#define FONT_N_COLUMNS      763
+#define FONT_N_GLYPHS       96
+#define FONT_N_EXTRAS       1
+
+// where a glyph's columns start in font_columns, and how many there are
+typedef struct font_glyph_struct {
+    uint16_t offset;
+    uint8_t width;
+} font_glyph;
+
+// a non-ASCII character in the atlas. font_extras is sorted by codepoint
+typedef struct font_extra_glyph_struct {
+    uint32_t codepoint;
+    uint8_t glyph;
+} font_extra_glyph;
+
+extern const uint16_t font_columns[FONT_N_COLUMNS];
+extern const font_glyph font_glyphs[FONT_N_GLYPHS];
+extern const uint8_t font_ascii[128];       // glyph of every ASCII character, '?' for the unprintable ones
+extern const font_extra_glyph font_extras[FONT_N_EXTRAS];
+
+
+/*
+Decodes the UTF-8 character at the start of s into codepoint
+Malformed sequences decode to a single '?' byte, so text from the USB port can never throw the layout off
+Returns the number of bytes used, 0 at the end of the string
+*/
+int font_decode_utf8(const char *s, uint32_t *codepoint);
+
+/*
+Returns the glyph that displays codepoint, the '?' glyph if it is not in the atlas
+*/
+const font_glyph *font_find_glyph(uint32_t codepoint);
+
+/*
+Returns the number of columns text takes up, with every glyph column repeated 'scale' times
+*/
+int font_text_width(const char *text, int scale);
+
+#endif
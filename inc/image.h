@@ -0,0 +1,66 @@
+/*
+Compressed colour images and animations for the light wand
+
+Images are stored in flash column after column, with every frame the same size. Each frame is a palette of up to
+IMAGE_MAX_COLORS colours shared by the whole image, and a run length encoding of the palette index of every pixel:
+pixel 0 to height-1 of column 0, then of column 1 and so on. A run is one byte, the number of pixels minus one in
+the high nibble and the palette index in the low nibble. Runs carry on from one column to the next, but every frame
+starts with a fresh run.
+
+Frames are decoded straight out of flash one column at a time, so only the column being decoded is ever expanded.
+src/images.c is generated from image files and GIFs by scripts/generate_image.py.
+*/
+#ifndef IMAGEH
+#define IMAGEH
+
+#include "pico/stdlib.h"
+
+#define IMAGE_MAX_COLORS    16
+#define IMAGE_RUN_MAX       16
+
+typedef struct image_color_struct {
+    uint8_t r, g, b, w;
+} image_color;
+
+typedef struct image_struct {
+    const char *name;
+    uint16_t width;             // columns per frame
+    uint16_t height;            // pixels per column
+    uint16_t n_frames;
+    uint16_t n_colors;
+    const image_color *palette;
+    const uint32_t *frames;     // where the runs of each frame start in data
+    const uint8_t *data;
+} image;
+
+// streaming decoder state, which picks up where the last column left off
+typedef struct image_decoder_struct {
+    const image *image;
+    const uint8_t *next;        // next run to read
+    uint8_t run;                // pixels left in the current run
+    uint32_t color;             // colour of the current run
+    uint32_t palette[IMAGE_MAX_COLORS];     // the palette as pixel words
+} image_decoder;
+
+// the images built into the firmware, defined in the generated src/images.c
+extern const image *const images[];
+extern const int n_images;
+
+
+/*
+Returns the built in image called name, or NULL if there is none
+*/
+const image *image_find(const char *name);
+
+/*
+Starts decoding the given frame of img from its first column
+Returns -1 if there is no such frame
+*/
+int image_decoder_start(image_decoder *decoder, const image *img, int frame);
+
+/*
+Decodes the next column of the frame into column, which takes the image's height in pixel words
+*/
+void image_decode_column(image_decoder *decoder, uint32_t *column);
+
+#endif
@@ -8,6 +8,8 @@ Functions for controlling neopixel arrays
 #include "pico/rand.h" 
 #include "hardware/pio.h"
 #include "hardware/clocks.h"
+#include "hardware/dma.h"
+#include "hardware/timer.h"
 #include "ws2812.pio.h"
 
 #include <stdio.h>
@@ -19,190 +21,230 @@ my use case 200us were needed. A possible explanation is that when pio_sm_is_tx_
 message is still being transmitted over the data line. Whatever the case, this works, and we don't need the wand to flicker
 particularly fast anyway 
 */
+#ifndef WS2812_END_SLEEP_US
 #define WS2812_END_SLEEP_US 200
+#endif
 
-/* 
-For a 15-count RGB neopixel strip:
-lights up the full strip as one color
-returns the amount of time in microseconds it took to resolve the function
+/*
+Pixel format of the strips, chosen at compile time with e.g. -DWS2812_PIXEL_FORMAT=WS2812_FORMAT_GRB. Pixels are
+kept in 32-bit words already laid out the way the strip wants them, first channel in the top byte, so nothing
+downstream of urgbw_u32 knows the format: the state machine shifts out the top WS2812_PIXEL_BITS bits of every word,
+and the white channel of a format without one lands in the low byte, which is never sent.
 */
-static inline uint64_t put_15_pixels_on_rgb(uint32_t pixel_grb) {
-    /*
-    pio_sm_put_blocking will always put out 32 bits, but we want to send 24 bit chunks in a
-    continuous stream. Therefore, some slightly more complicated looping behaviour is required
-    */
+#define WS2812_FORMAT_GRBW  0
+#define WS2812_FORMAT_RGBW  1
+#define WS2812_FORMAT_GRB   2
+#define WS2812_FORMAT_RGB   3
+
+#ifndef WS2812_PIXEL_FORMAT
+#define WS2812_PIXEL_FORMAT WS2812_FORMAT_GRBW
+#endif
+
+#if WS2812_PIXEL_FORMAT == WS2812_FORMAT_GRBW || WS2812_PIXEL_FORMAT == WS2812_FORMAT_GRB
+#define WS2812_G_SHIFT      24
+#define WS2812_R_SHIFT      16
+#elif WS2812_PIXEL_FORMAT == WS2812_FORMAT_RGBW || WS2812_PIXEL_FORMAT == WS2812_FORMAT_RGB
+#define WS2812_R_SHIFT      24
+#define WS2812_G_SHIFT      16
+#else
+#error "WS2812_PIXEL_FORMAT must be one of the WS2812_FORMAT_ values"
+#endif
+#define WS2812_B_SHIFT      8
+#define WS2812_W_SHIFT      0
+
+#if WS2812_PIXEL_FORMAT == WS2812_FORMAT_GRBW || WS2812_PIXEL_FORMAT == WS2812_FORMAT_RGBW
+#define WS2812_PIXEL_BITS   32
+#else
+#define WS2812_PIXEL_BITS   24
+#endif
+
+// number of pixels on each strip, and the time it takes to shift one pixel out at 800kHz
+#ifndef WS2812_N_PIXELS
+#define WS2812_N_PIXELS     15
+#endif
+#define WS2812_PIXEL_US     (WS2812_PIXEL_BITS * 5 / 4)
 
-    int color_channel = 0; // 0: green, 1: red, 2: blue
-    int transmitted_bytes = 0;
-    int i;
-    uint64_t start_us = time_us_64();
+/*
+Number of strips driven at once, on consecutive pins from TX_PIN. A single strip is driven by the ws2812 program.
+Several strips are driven by the ws2812_parallel program, which shifts one bit of every strip out per FIFO word, so
+every pixel is turned into WS2812_PIXEL_BITS bit planes on its way out (see ws2812_transpose_column). All the strips fill in the
+time one would, which adds vertical resolution without lowering the column rate.
+*/
+#ifndef WS2812_N_STRIPS
+#define WS2812_N_STRIPS     1
+#endif
+#if WS2812_N_STRIPS < 1 || WS2812_N_STRIPS > 32
+#error "WS2812_N_STRIPS must be 1 to 32"
+#endif
+
+// pixels in a column of the display: the pixels of strip 0, then of strip 1 and so on
+#define WS2812_COLUMN_PIXELS    (WS2812_N_PIXELS * WS2812_N_STRIPS)
+
+// FIFO words it takes to send a column
+#if WS2812_N_STRIPS > 1
+#define WS2812_COLUMN_WORDS     (WS2812_N_PIXELS * WS2812_PIXEL_BITS)
+#else
+#define WS2812_COLUMN_WORDS     WS2812_N_PIXELS
+#endif
 
-    while(1) {
-        uint32_t msg = 0;
-        for(i=3; i>=0; i--) {
-            // get the next color channel value
-            uint8_t color_val = ((pixel_grb >> ((2-color_channel) * 8u)) & 0xff);
-
-            // push the next color channel value onto the transmission message
-            msg |= color_val << (i * 8u); 
-            color_channel = (color_channel + 1) % 3;
-            transmitted_bytes++;
-        }
-
-        // transmit the next 32-bit chunk of control data
-        pio_sm_put_blocking(pio0, 0, msg);
-
-        if (transmitted_bytes >= 45) {
-            // 45 bytes of color data, for 15 pixels, have been transmitted
-            break;
-        }
-    }
+/*
+Turns a column of WS2812_COLUMN_PIXELS pixels into the WS2812_COLUMN_WORDS words the ws2812_parallel program
+shifts out: word WS2812_PIXEL_BITS * i + b holds bit 31 - b of pixel i of every strip, strip s in bit s.
+*/
+void ws2812_transpose_column(const uint32_t *column, uint32_t *planes);
 
+/*
+Puts a column of WS2812_COLUMN_PIXELS pixels into the TX FIFO, blocking while it is full
+*/
+void ws2812_put_column(const uint32_t *column);
+
+/*
+Waits for the column to leave the TX FIFO, then for the strip to latch it
+returns the amount of time in microseconds since start_us
+*/
+static inline uint64_t ws2812_latch(uint64_t start_us) {
     // wait for the tx fifo to drain
     while (!pio_sm_is_tx_fifo_empty(pio0, 0))
         sleep_us(1);
 
-    sleep_us(WS2812_END_SLEEP_US);   
+    sleep_us(WS2812_END_SLEEP_US);    // additional wait so WS2812 knows to finish transaction
 
-    return time_us_64() - start_us; 
+    return time_us_64() - start_us;
 }
 
 /*
-For a 15-count RGB neopixel strip:
-parses the bits of a 32 bit integer and turns leds on or off based on the bits
-returns the amount of time in microseconds it took to resolve the function
+Fills a column of WS2812_COLUMN_PIXELS pixels from a mask: pixel i is color_on if bit i of bits is set and color_off
+otherwise. Pixels past the 32nd are off
 */
-static inline uint64_t put_15_pixels_rgb(uint32_t bits, uint32_t color_on, uint32_t color_off)
+static inline void ws2812_mask_column(uint32_t bits, uint32_t color_on, uint32_t color_off, uint32_t *column)
 {
-    int color_channel = 0; // 0: green, 1: red, 2: blue
-    int transmitted_bytes = 0;
+    uint32_t bit;
     int i;
-    uint64_t start_us = time_us_64();
 
-    uint8_t color_val;
-
-    while(1) {
-        uint32_t msg = 0;
-        for(i=3; i>=0; i--) {
-            // choose whether we are in an "on" or "off" pixel
-            if (((bits >> (transmitted_bytes/3)) & 1) == 1)
-                color_val = ((color_on >> ((2-color_channel) * 8u)) & 0xff);
-            else
-                color_val = ((color_off >> ((2-color_channel) * 8u)) & 0xff);
-
-            // push the next color channel value onto the transmission message
-            msg |= color_val << (i * 8u); 
-            color_channel = (color_channel + 1) % 3;
-            transmitted_bytes++;
-        }
-
-        // transmit the next 32-bit chunk of control data
-        pio_sm_put_blocking(pio0, 0, msg);
-
-        if (transmitted_bytes >= 45) {
-            // 45 bytes of color data, for 15 pixels, have been transmitted
-            break;
-        }
+    for (i = 0; i < WS2812_COLUMN_PIXELS && i < 32; i++) {
+        // pick the colour without a branch: the mask is all ones for a set bit, and all zeros otherwise
+        bit = (bits >> i) & 1;
+        column[i] = color_off ^ ((color_on ^ color_off) & -bit);
     }
-
-    // wait for the tx fifo to drain
-    while (!pio_sm_is_tx_fifo_empty(pio0, 0))
-        sleep_us(1);
-
-    sleep_us(WS2812_END_SLEEP_US);    // additional wait so WS2812 knows to finish transaction
-
-    return time_us_64() - start_us; 
+    for (; i < WS2812_COLUMN_PIXELS; i++)
+        column[i] = color_off;
 }
 
-
 /* 
-For a 15-count RGBW neopixel strip:
-lights up the full strip as one color
+lights up every strip as one color
 returns the amount of time in microseconds it took to resolve the function
 */
-static inline uint64_t put_15_pixels_on_rgbw(uint32_t pixel_grbw) {
+static inline uint64_t put_pixels_on(uint32_t color) {
+    uint32_t column[WS2812_COLUMN_PIXELS];
     uint64_t start_us = time_us_64();
 
-    // The code for controlling an RGBW strip is much simpler than for the RGB strips.
-    for (int i = 0; i < 15; i++) {
-        pio_sm_put_blocking(pio0, 0, pixel_grbw);
-    }
-
-    // wait for the tx fifo to drain
-    while (!pio_sm_is_tx_fifo_empty(pio0, 0))
-        sleep_us(1);
-
-        
-    sleep_us(WS2812_END_SLEEP_US);
+    for (int i = 0; i < WS2812_COLUMN_PIXELS; i++)
+        column[i] = color;
+    ws2812_put_column(column);
 
-    return time_us_64() - start_us;
+    return ws2812_latch(start_us);
 }
 
 /* 
-For a 15-count RGBW neopixel strip:
-parses the bits of a 32 bit integer and turns leds on or off based on the bits
+parses the bits of a 32 bit integer and turns leds on or off based on the bits. Pixels past the 32nd are off
 returns the amount of time in microseconds it took to resolve the function
 */
-static inline uint64_t put_15_pixels_rgbw(uint32_t bits, uint32_t color_on, uint32_t color_off) {
+static inline uint64_t put_pixels(uint32_t bits, uint32_t color_on, uint32_t color_off) {
+    uint32_t column[WS2812_COLUMN_PIXELS];
     uint64_t start_us = time_us_64();
 
-    // The code for controlling an RGBW strip is much simpler than for the RGB strips.
-    for (int i = 0; i < 15; i++) {
-        if (((bits >> i) & 1) == 1) {
-            pio_sm_put_blocking(pio0, 0, color_on);
-        }
-        else {
-            pio_sm_put_blocking(pio0, 0, color_off);
-        }
-    }
-
-    // wait for the tx fifo to drain
-    while (!pio_sm_is_tx_fifo_empty(pio0, 0))
-        sleep_us(1);
-
-        
-    sleep_us(WS2812_END_SLEEP_US);
+    ws2812_mask_column(bits, color_on, color_off, column);
+    ws2812_put_column(column);
 
-    return time_us_64() - start_us;
+    return ws2812_latch(start_us);
 }
 
 /*
-For a 15-count RGBW neopixel strip:
 spits random color data onto the wand (adjusted to be prettier)
-    white_mask is and-ed with the white channel of the random pixel color
+    white_mask is and-ed with the white channel of the random pixel color, if the strips have one
 */
-static inline uint64_t put_15_random_rgbw(uint8_t white_mask) {
+static inline uint64_t put_random(uint8_t white_mask) {
+    uint32_t column[WS2812_COLUMN_PIXELS];
     uint64_t start_us = time_us_64();
 
-    for (int i = 0; i < 15; i++) {
-        pio_sm_put_blocking(pio0, 0, get_rand_32() & 0xFFFFFF00 | white_mask);
-    }
-
-    // wait for the tx fifo to drain
-    while (!pio_sm_is_tx_fifo_empty(pio0, 0))
-        sleep_us(1);
-        
-    sleep_us(WS2812_END_SLEEP_US);    
+    for (int i = 0; i < WS2812_COLUMN_PIXELS; i++)
+        column[i] = (get_rand_32() & ~(0xFFu << WS2812_W_SHIFT)) | ((uint32_t)white_mask << WS2812_W_SHIFT);
+    ws2812_put_column(column);
 
-    return time_us_64() - start_us; 
+    return ws2812_latch(start_us);
 }
 
-// taken from hutscape.github.io. Converts r, g, b, to urgb
+// Converts r, g, b to a pixel in the strips' format
 static inline uint32_t urgb_u32(uint8_t r, uint8_t g, uint8_t b) {
-    return  ((uint32_t)(b) << 0)    |
-            ((uint32_t)(r) << 8)    |
-            ((uint32_t)(g) << 16);
+    return  ((uint32_t)(r) << WS2812_R_SHIFT)   |
+            ((uint32_t)(g) << WS2812_G_SHIFT)   |
+            ((uint32_t)(b) << WS2812_B_SHIFT);
 }
 
-// Converts r, g, b, w, to urgbw
+// Converts r, g, b, w to a pixel in the strips' format. w is dropped by strips without a white channel
 static inline uint32_t urgbw_u32(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
-    return  ((uint32_t)(b) << 8)    |
-            ((uint32_t)(r) << 16)    |
-            ((uint32_t)(g) << 24)   |
-            ((uint32_t)(w) << 0);
+    return  ((uint32_t)(r) << WS2812_R_SHIFT)   |
+            ((uint32_t)(g) << WS2812_G_SHIFT)   |
+            ((uint32_t)(b) << WS2812_B_SHIFT)   |
+            ((uint32_t)(w) << WS2812_W_SHIFT);
 }
 
-// sets up the ws2812 controller
+// sets up the ws2812 controller, with the ws2812_parallel program if there are several strips
 void setup_ws2812();
 
+/*
+DMA display engine
+
+Shows a swing of prerendered columns without the CPU pushing any pixels. frames is a ring of n_frame_cols columns of
+n_pixels 32-bit words, which must be WS2812_COLUMN_PIXELS when driving several strips. Each column is released by a hardware alarm
+at start_us + col_due_us[i], from a table worked out for the swing before it starts, and DMA streams its words into
+the ws2812 state machine. With several strips, the
+alarm transposes the column after the one it releases while the DMA runs, so it is ready when its alarm fires.
+Columns are timed against the start of the swing, so lateness never accumulates, and the latch gap is simply the
+idle time between columns.
+
+setup_ws2812_dma must be called from the core that should service the alarm interrupt.
+*/
+void setup_ws2812_dma();
+
+// column step of a swing that shows every column. Steps have this many fractional parts
+#define WS2812_COL_STEP_ONE     256
+
+/*
+Starts showing a swing of n_cols columns, replacing any swing still in progress. Column i of the swing is column
+first + i * col_step / WS2812_COL_STEP_ONE of frames, wrapping around to the start of the ring: WS2812_COL_STEP_ONE
+shows every column, and larger steps skip some to fit a wider frame into fewer columns. The swing must span fewer
+than n_frame_cols columns. If reverse is set, the columns are shown last to first. Column i goes out
+col_due_us[i] after start_us. The times must leave at least ws2812_dma_min_col_time_us between columns, and the
+table is read until the swing is over, so it must be left alone until the next swing has been started.
+*/
+void ws2812_dma_show_swing(const uint32_t *frames, uint n_pixels, uint n_frame_cols, uint first, uint n_cols,
+                           uint32_t col_step, bool reverse, uint64_t start_us, const uint32_t *col_due_us);
+
+/*
+Returns the shortest time a column of n_pixels can be shown for: its time on the wire plus the latch gap
+*/
+uint32_t ws2812_dma_min_col_time_us(uint n_pixels);
+
+/*
+Stops the swing in progress after the column currently being sent
+*/
+void ws2812_dma_stop();
+
+/*
+Stops the swing in progress, and turns every pixel off once the column being sent has gone out
+*/
+void ws2812_dma_blank();
+
+/*
+Returns the number of columns of the current (or last) swing that have been sent to the strip
+*/
+uint ws2812_dma_columns_shown();
+
+/*
+Returns the number of columns of the current (or last) swing that were dropped because the DMA was still sending the
+column before when they were due
+*/
+uint ws2812_dma_columns_dropped();
+
 #endif
\ No newline at end of file
@@ -0,0 +1,383 @@
+/*
+Persistence of vision logic for the light wand
+
+Core 0 feeds accelerometer samples into the direction detector, which signals core 1 every time the wand changes direction.
+Core 1 then displays the columns of the message for the duration of that swing.
+
+Nothing in here touches the accelerometer or GPIO directly, so the same code is compiled into the host-side simulator
+(see sim/), which replays recorded swings against stand-in versions of the SDK functions used here.
+*/
+#ifndef POVH
+#define POVH
+
+#include "pico/stdlib.h"
+
+#include "neopixels.h"
+#include "ADXL343.h"
+#include "predictor.h"
+#include "font.h"
+#include "image.h"
+
+// defines relating to accelerometer sampling
+// samples collect in the ADXL343's FIFO, and are handed to the direction detector in batches of ADX_FIFO_WATERMARK
+#define ADX_DATA_RATE           ADXL3XX_DATARATE_800_HZ
+#define ADX_SAMPLE_PERIOD_US    (1000000 / 800)
+#ifndef ADX_FIFO_WATERMARK
+#define ADX_FIFO_WATERMARK      8
+#endif
+#if ADX_FIFO_WATERMARK < 1 || ADX_FIFO_WATERMARK > ADXL3XX_FIFO_SAMPLES_MAX
+#error "ADX_FIFO_WATERMARK must be 1 to ADXL3XX_FIFO_SAMPLES_MAX"
+#endif
+
+// defines relating to wand position
+// the displayed direction only follows the jerk once it has kept the same sign for DIR_RUN_LENGTH samples.
+// This is the default, it can be changed at runtime with pov_detector_set_run_length
+#define ACCEL_MAX_MSS               30
+#ifndef DIR_RUN_LENGTH
+#define DIR_RUN_LENGTH          24
+#endif
+#define DIR_RUN_LENGTH_MAX      255
+
+// how the length of the next swing is predicted from the reversals, see predictor.h
+#ifndef POV_PREDICTOR
+#define POV_PREDICTOR           PREDICTOR_PLL
+#endif
+
+// predictive reversals: the turnaround is predicted from when the wand passed its fastest point, and once the predictor
+// is at least POV_ANTICIPATE_CONFIDENCE (0-255) sure of itself and agrees, the next swing is started up to
+// POV_ANTICIPATE_LEAD_US before it, as the batch after would already be too late. The hysteresis still has to confirm
+// the reversal, and restarts the swing if the prediction was more than 1/POV_ANTICIPATE_TOLERANCE_DIV of a swing out.
+// A confidence above 255 turns the prediction off
+#ifndef POV_ANTICIPATE_CONFIDENCE
+#define POV_ANTICIPATE_CONFIDENCE   230
+#endif
+#define POV_ANTICIPATE_LEAD_US      (ADX_FIFO_WATERMARK * ADX_SAMPLE_PERIOD_US)
+#ifndef POV_ANTICIPATE_TOLERANCE_DIV
+#define POV_ANTICIPATE_TOLERANCE_DIV    16
+#endif
+
+// defines relating to text display
+#define PIXEL_CHAR_COLOR        urgbw_u32(0, 0, 255, 128)
+#define PIXEL_BG_COLOR          urgbw_u32(0, 0, 0, 0)
+#define PIXEL_REST_COLOR        urgbw_u32(0, 0, 0, 0)
+
+// the message is centered in the columns, and scaled as well
+#define MESSAGE_CHAR_SCALE      2   // 2 to double the width of the characters
+#ifndef N_DISPLAY_COLUMNS
+#define N_DISPLAY_COLUMNS       200
+#endif
+
+/*
+The wand is fastest in the middle of a swing and slowest at the ends, so spacing the columns evenly in time would
+stretch the middle of the message and squash its ends. Each column is instead shown when the wand reaches its place
+in the display, from a profile of where in a swing every display column is due, which each swing scales into a table
+of column times for the DMA engine, so nothing is computed per column. Where the columns come closest together sets
+how many fit into a swing.
+
+    0   columns evenly spaced in time
+    1   a pendulum: t into a swing of length T the wand has come (1 - cos(pi * t / T)) / 2 of the way across.
+        Worked out once by pov_display_init
+    2   fitted to the wand's own motion. At every reversal core 0 integrates the acceleration of the half swing that
+        just ended twice, with the wand at rest at both ends, and finds when it passed each display column. A swing
+        is shown with the profile of the last one in the same direction, or of the last one the other way until
+        there is one. Falls back on 1 until a half swing of at most POV_PROFILE_SAMPLES has been seen
+*/
+#ifndef POV_VELOCITY_PROFILE
+#define POV_VELOCITY_PROFILE    2
+#endif
+
+// samples of the latest half swings kept for fitting the profile to. Must be a power of two
+#ifndef POV_PROFILE_SAMPLES
+#define POV_PROFILE_SAMPLES     1024
+#endif
+// shortest half swing a profile is fitted to, in samples
+#define POV_PROFILE_MIN_SAMPLES 16
+
+// text shown until a new message is uploaded, and the longest message that can be uploaded, in UTF-8 bytes
+#define POV_DEFAULT_TEXT        "ECE"
+#define POV_MAX_TEXT_LEN        128
+
+// text too long for the display scrolls past as a marquee, this many columns per swing. 0 rejects it instead
+#ifndef POV_DEFAULT_SCROLL
+#define POV_DEFAULT_SCROLL      4
+#endif
+// blank font columns (before scaling) between the end of a scrolling message and its start coming round again
+#define POV_MARQUEE_GAP         16
+
+/*
+The framebuffer is a ring of twice as many columns as are displayed, holding the ready-to-send pixel words of every
+column, column after column. Swings show the N_DISPLAY_COLUMNS from the display origin on, and the renderer writes
+the ones after them (the back buffer), which are moved into view at a swing boundary. A full render moves the
+window on by all of them, which flips between the two halves of the ring like a double buffer, and a marquee only
+by the few columns that scrolled in.
+*/
+#define POV_RING_COLUMNS        (2 * N_DISPLAY_COLUMNS)
+#define POV_FRAMEBUFFER_WORDS   (POV_RING_COLUMNS * WS2812_COLUMN_PIXELS)
+
+/*
+State of the jerk based direction detector run on core 0
+Only the sign of the jerk matters, and the sample period is always positive, so the detector works on the
+difference of consecutive raw counts. Hysteresis is a run length counter rather than a history of directions.
+A confirmed reversal is dated back to the extreme of the acceleration, where the wand actually turned around,
+rather than to the sample the hysteresis ran out on.
+The detector also keeps the latest samples, and the velocity profiles fitted to them, see POV_VELOCITY_PROFILE. It
+is too big for a core's stack.
+*/
+typedef struct pov_detector_struct {
+    int16_t prev_ax_raw;
+    uint8_t hidden_dir;         // direction of the last non-zero jerk
+    uint8_t hidden_run;         // samples hidden_dir has held for, saturating at DIR_RUN_LENGTH_MAX
+    uint8_t display_dir;        // direction being displayed
+    uint8_t run_length;         // samples hidden_dir must hold for before display_dir follows it
+    int16_t extreme_ax_raw;     // furthest the acceleration has gone in display_dir since the last reversal
+    uint64_t extreme_us;        // first sample it was reached on
+    uint64_t extreme_end_us;    // and the last
+    uint32_t extreme_n;         // the samples they were, counted by n_samples
+    uint32_t extreme_end_n;
+    int16_t reversal_ax_raw;    // acceleration at the last reversal
+    int16_t mid_ax_raw;         // halfway between it and the one before, where the wand is at its fastest
+    uint64_t crossing_us;       // when the acceleration crossed mid_ax_raw in this swing, 0 until it has
+    uint64_t prev_dir_change_time;
+    uint64_t prev_swing_time_length;
+    uint32_t n_reversals;       // number of direction changes confirmed so far
+    uint32_t seq;               // number of swings signalled so far, anticipated ones and restarts included
+    bool anticipated;           // a swing was already started for the reversal that is yet to be confirmed
+    uint64_t anticipated_us;    // and the time it was started from
+    predictor predictor;        // predicts the length of each swing from the reversal times
+    uint32_t n_samples;         // samples fed in so far
+    uint32_t reversal_n;        // sample the last reversal was dated to
+    bool fit_pending;           // the half swing from fit_n to reversal_n is waiting for pov_fit_profile
+    uint8_t fit_dir;            // the display direction it was shown in
+    uint32_t fit_n;
+    int16_t samples[POV_PROFILE_SAMPLES];   // ring of the latest samples, indexed by n_samples
+    bool fitted[2];             // a profile has been fitted to a half swing in that display direction
+    uint16_t profile_min_step[2];
+    uint16_t profile[2][N_DISPLAY_COLUMNS]; // and that profile, as in pov_swing
+} pov_detector;
+
+// everything core 1 needs to know about a swing, written by core 0 when the wand changes direction
+typedef struct pov_swing_struct {
+    uint32_t seq;               // number of the swing, counting from 1
+    uint64_t reversal_us;       // time since boot the swing starts at, which is in the future for an anticipated one
+    uint32_t period_us;         // measured length of the swing that just ended
+    uint32_t predicted_us;      // expected length of the swing that starts at reversal_us
+    uint8_t dir;                // display direction of the new swing
+    uint8_t confidence;         // 0-255, how well the predictor had anticipated this reversal
+    bool fitted;                // profile was fitted to the wand's motion. Otherwise the display's own is used
+    uint16_t profile[N_DISPLAY_COLUMNS];    // fraction of the way through the swing (out of 65536) each display
+                                            // column is due at, counting from the side the swing starts on
+    uint16_t profile_min_step;  // smallest fraction of the swing between neighbouring columns of profile
+} pov_swing;
+
+// single producer (core 0), single consumer (core 1) ring of swings. Must be a power of two
+#define POV_SWING_RING_SIZE     8
+
+/*
+Lock-free ring of swing descriptors shared between the cores
+head is only written by the producer and tail only by the consumer, so neither side ever waits on the other.
+A swing pushed onto a full ring is dropped and counted, rather than blocking the sensor loop.
+*/
+typedef struct pov_swing_ring_struct {
+    pov_swing slots[POV_SWING_RING_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;
+} pov_swing_ring;
+
+// the ring core 0 signals core 1 through. The inter-core FIFO only carries a doorbell to wake core 1 up
+extern pov_swing_ring pov_swings;
+
+// how the swings have fit into their column budgets, kept by core 1 as it starts each swing
+typedef struct pov_display_stats_struct {
+    uint32_t swings;            // swings started
+    uint32_t decimated;         // swings shown at a lower resolution to fit into their predicted length
+    uint32_t overruns;          // swings cut short by the next one before all their columns were shown
+    uint32_t columns_cut;       // columns never shown because of overruns
+    uint32_t columns_dropped;   // columns dropped because the DMA was still sending the one before
+    uint32_t last_seq;          // seq of the swing started last
+    uint16_t last_columns;      // columns it was given, out of N_DISPLAY_COLUMNS
+} pov_display_stats;
+
+extern volatile pov_display_stats pov_stats;
+
+/*
+Background renderer, which builds new content into the back framebuffer one column at a time
+Core 1 steps it in the time between swings, and it swaps the buffers itself once the last column is done.
+It either renders text, or decodes an image. Animated images move on to their next frame as soon as the last one
+has been swapped in, so they advance one frame per swing.
+Text too long for the display is shown as a marquee: the first N_DISPLAY_COLUMNS columns are rendered as usual, and
+after that only the scroll columns that come into view at each swing, laid out straight from the font as they are
+needed. The message wraps around, after a gap of POV_MARQUEE_GAP columns.
+*/
+typedef struct pov_renderer_struct {
+    char text[POV_MAX_TEXT_LEN + 1];
+    int scale;
+    int scroll;                 // columns a marquee moves on per swing
+    uint32_t color_on;
+    uint32_t color_off;
+    uint32_t columns[N_DISPLAY_COLUMNS];    // the text laid out by build_columns, unless it is a marquee
+    bool marquee;               // the text is too long for the display, and scrolls past
+    int text_pos;               // marquee: byte of text the next column comes from, the gap after the text at its end
+    int glyph_col;              // marquee: column of that glyph (or of the gap) the next column shows, before scaling
+    int repeat;                 // marquee: times that column has been repeated so far, up to scale
+    const image *image;         // image being shown, NULL when showing text
+    image_decoder decoder;
+    int frame;                  // frame of the image being rendered
+    int render_cols;            // columns in the render in progress: N_DISPLAY_COLUMNS, or scroll for a marquee
+    int next_col;               // next column to render, render_cols once the render is finished
+} pov_renderer;
+
+
+/*
+Resets the direction detector to its power-on state, predicting swing lengths with POV_PREDICTOR
+*/
+void pov_detector_init(pov_detector *detector);
+
+/*
+Sets how many samples in a row the jerk must keep its sign before the displayed direction follows it
+run_length is clamped to 1 - DIR_RUN_LENGTH_MAX
+*/
+void pov_detector_set_run_length(pov_detector *detector, uint run_length);
+
+/*
+Feeds one x axis sample, read at time 'now', into the direction detector.
+'now' is only used to time the swings, the direction itself is found from the raw counts alone.
+When the displayed direction changes, core 1 is signalled to start the next swing.
+
+Returns true if the displayed direction changed
+*/
+bool pov_update_direction(pov_detector *detector, uint64_t now, int16_t ax_raw);
+
+/*
+Fits the velocity profile to the half swing that ended at the last reversal, if it hasn't been yet. The fit runs over
+the whole half swing, so it is kept out of pov_update_direction: call once per batch, after its samples have been fed
+in and before pov_anticipate_reversal. Does nothing unless POV_VELOCITY_PROFILE is 2
+*/
+void pov_fit_profile(pov_detector *detector);
+
+/*
+Starts the next swing ahead of the hysteresis, if the wand is confidently predicted to turn around within
+POV_ANTICIPATE_LEAD_US of 'now'. Call once per batch of samples, with the time the batch was read.
+The swing in progress is cut short by up to POV_ANTICIPATE_LEAD_US, at its very end where the wand is slowest.
+At most one swing is anticipated per reversal, and the display direction only changes once pov_update_direction
+confirms it.
+
+Returns true if a swing was signalled
+*/
+bool pov_anticipate_reversal(pov_detector *detector, uint64_t now);
+
+/*
+Hands a swing to Core 1 that starts displaying the next cycle
+The swing goes into pov_swings, and its seq is pushed onto the inter-core FIFO as a doorbell if there is room.
+Never blocks.
+*/
+void signal_dirchange(const pov_swing *swing);
+
+/*
+Empties the ring and clears its drop count
+*/
+void pov_swing_ring_init(pov_swing_ring *ring);
+
+/*
+Producer side: copies swing into the ring
+Returns false if the ring was full, in which case the swing is dropped
+*/
+bool pov_swing_ring_push(pov_swing_ring *ring, const pov_swing *swing);
+
+/*
+Consumer side: copies the oldest swing in the ring into out
+Returns false if the ring was empty
+*/
+bool pov_swing_ring_pop(pov_swing_ring *ring, pov_swing *out);
+
+/*
+Returns the WS2812_COLUMN_PIXELS pixel words of column c (0 to N_DISPLAY_COLUMNS - 1) of the back buffer, which is
+not being displayed and can be rendered into freely. Columns are not contiguous, the ring may wrap between them.
+Returns NULL while a swap is still pending, as the back buffer is about to be shown.
+*/
+uint32_t *pov_back_column(uint c);
+
+/*
+Expands N_DISPLAY_COLUMNS column masks into the back buffer: color_on for every set bit, color_off otherwise
+Returns -1 if a swap is still pending
+*/
+int pov_render_columns(const uint32_t *columns, uint32_t color_on, uint32_t color_off);
+
+/*
+Shows the back buffer from the start of the next swing on. The swing in progress is not disturbed.
+*/
+void pov_swap_buffers();
+
+/*
+Moves the display window n_cols (1 to N_DISPLAY_COLUMNS) columns on from the start of the next swing, showing the
+first n_cols columns of the back buffer at its end. The swing in progress is not disturbed.
+*/
+void pov_scroll_buffers(uint n_cols);
+
+/*
+Starts rendering text (UTF-8) in the given colours into the back framebuffer, abandoning any render in progress
+Text that does not fit in N_DISPLAY_COLUMNS at that scale is shown as a marquee, moving on scroll columns per swing.
+Returns -1 if it does not fit and scroll is 0, leaving the renderer untouched
+*/
+int pov_renderer_start(pov_renderer *renderer, const char *text, int scale, int scroll, uint32_t color_on,
+                       uint32_t color_off);
+
+/*
+Starts playing img in place of the text, with color_off around it, abandoning any render in progress
+Returns -1 if img is too wide or too tall for the display, leaving the renderer untouched
+*/
+int pov_renderer_start_image(pov_renderer *renderer, const image *img, uint32_t color_off);
+
+/*
+Renders the next column. Once the last column is done, the new content is swapped in at the next swing.
+Does nothing while the back buffer is still waiting to be swapped in.
+Returns true if there is more work that can be done right away, false once the render is finished or while it waits
+for the swap, which only happens when a swing starts
+*/
+bool pov_renderer_step(pov_renderer *renderer);
+
+/*
+Works out where in a swing each display column is due until a profile has been fitted, see POV_VELOCITY_PROFILE.
+Must be called before the first swing is displayed
+*/
+void pov_display_init();
+
+/*
+Returns true if core 0 has signalled a swing that has not been displayed yet
+*/
+bool pov_swing_pending();
+
+/*
+Waits for core 0 to signal a change of direction, then starts the DMA engine displaying the front framebuffer
+across the newest swing in pov_swings, swapping buffers first if a swap was requested. The columns are scheduled from
+the time of the reversal itself, not from when this core woke up. Returns without waiting for the swing to be
+displayed. setup_ws2812_dma must have been called on this core first.
+
+If the predicted swing is too short for every column to be shown, as many as fit are picked evenly from across the
+framebuffer. Swings that were cut short anyway are counted as overruns in pov_stats.
+
+Returns the number of columns of the previous swing that were displayed before it was replaced
+*/
+int pov_display_next_swing();
+
+/*
+Picks which framebuffer columns a swing given n_cols columns shows: column i of the swing shows framebuffer column
+first + i * step / WS2812_COL_STEP_ONE
+Returns first
+*/
+uint pov_column_layout(uint n_cols, uint32_t *step);
+
+/*
+Same as pov_display_next_swing, but returns -1 straight away if no swing has been signalled. Safe to call from the
+inter-core FIFO interrupt, as long as the DMA engine's alarm interrupt has the same priority.
+*/
+int pov_start_next_swing();
+
+/*
+Lays text (UTF-8) out in the proportional font, one column mask per column
+The text is centered in the columns, and every glyph column is repeated 'scale' times
+Returns -1 if the text does not fit in n_cols, leaving columns untouched
+*/
+int build_columns(const char *text, uint32_t *columns, int n_cols, int scale);
+
+#endif
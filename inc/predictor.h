@@ -0,0 +1,69 @@
+/*
+Swing period predictors
+
+The direction detector only tells when the wand reversed. A predictor turns those reversal times into an estimate of
+how long the swing that is just starting will take, so the columns can be spread across it. Predictors are plain
+integer code with no SDK dependencies, so they can be run against recorded captures on the host (see sim/).
+
+    PREDICTOR_LAST  the next swing takes as long as the last one did
+    PREDICTOR_EWMA  exponentially weighted average of the last swing lengths
+    PREDICTOR_PLL   phase locked loop on the reversal times, which also follows a steady speed up or slow down
+*/
+#ifndef PREDICTORH
+#define PREDICTORH
+
+#include "pico/stdlib.h"
+
+// a swing longer than this is the wand resting, and the predictor starts over on the next one
+#define PREDICTOR_MAX_PERIOD_US     1500000
+
+// weight of the newest swing in the EWMA is 1/PREDICTOR_EWMA_DIV
+#ifndef PREDICTOR_EWMA_DIV
+#define PREDICTOR_EWMA_DIV          4
+#endif
+
+// the PLL corrects its phase by 1/PREDICTOR_PLL_PHASE_DIV, and its period by 1/PREDICTOR_PLL_PERIOD_DIV of each error
+#ifndef PREDICTOR_PLL_PHASE_DIV
+#define PREDICTOR_PLL_PHASE_DIV     2
+#endif
+#ifndef PREDICTOR_PLL_PERIOD_DIV
+#define PREDICTOR_PLL_PERIOD_DIV    4
+#endif
+
+typedef enum predictor_kind_enum {
+    PREDICTOR_LAST,
+    PREDICTOR_EWMA,
+    PREDICTOR_PLL
+} predictor_kind;
+
+typedef struct predictor_struct {
+    predictor_kind kind;
+    uint64_t prev_reversal_us;  // last reversal fed in, 0 before the first one
+    uint64_t phase_us;          // estimated time of the last reversal
+    uint32_t period_us;         // estimated length of the swing that started at phase_us, 0 until one has been seen
+    uint8_t confidence;         // 0-255, how well the last reversal matched the prediction
+} predictor;
+
+
+/*
+Resets the predictor, and selects which kind of prediction it makes
+*/
+void predictor_init(predictor *p, predictor_kind kind);
+
+/*
+Feeds the time of a reversal of the wand into the predictor
+*/
+void predictor_update(predictor *p, uint64_t reversal_us);
+
+/*
+Returns the predicted time of the next reversal, or 0 if there is no prediction yet
+*/
+uint64_t predictor_next_reversal(const predictor *p);
+
+/*
+Parses "last", "ewma" or "pll"
+Returns -1 if the name is unknown
+*/
+int predictor_kind_from_name(const char *name, predictor_kind *kind);
+
+#endif
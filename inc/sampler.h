@@ -0,0 +1,120 @@
+/*
+Asynchronous sampling of the accelerometer
+
+Core 0 never waits on the bus for samples. The accelerometer's WATERMARK interrupt starts a transfer of the batch,
+which DMA moves off the bus while core 0 carries on with the last one. Without INT1 wired to the pico, the sampler's
+alarm starts one every batch period instead. The transfer reads FIFO_STATUS first and then
+drains every entry it counted, which may be more than the watermark. When it completes, the DMA interrupt timestamps
+the samples and pushes them into a ring in RAM, which core 0 pops them from.
+
+    i2c     the register address and read commands of every entry are queued into the i2c's command FIFO by one DMA
+            channel while another collects the bytes read, so the whole batch is a single transfer
+    SPI     each entry needs a chip select of its own to pop it off the FIFO, so the DMA interrupt raises chip select
+            after each one, and an alarm starts the next once the FIFO has had time to pop
+    mock    the batch is read as soon as it is asked for, which is how the simulator runs it
+
+INT_SOURCE is read at the end of every batch, in the same transfer, so the accelerometer's other interrupts can share
+INT1 with WATERMARK without core 0 having to ask the bus what fired.
+
+The accelerometer doesn't say when a sample was measured, so each batch carries on a sample period after the last
+sample of the one before. The cadence is only taken up again from the time FIFO_STATUS was read when samples were lost
+(a full FIFO, a transfer that timed out) or the two clocks have drifted more than a sample period apart, and those
+times are counted.
+
+A transfer that hasn't completed ADX_SAMPLER_TIMEOUT_US after it started is aborted and counted, and so is a batch
+that never signals or a poll that finds the FIFO empty, so a stuck sensor or bus costs some samples rather than
+freezing the wand.
+*/
+#ifndef SAMPLERH
+#define SAMPLERH
+
+#include "pico/stdlib.h"
+
+#include "ADXL343.h"
+
+// samples the ring holds. Must be a power of two
+#ifndef ADX_SAMPLER_RING_SIZE
+#define ADX_SAMPLER_RING_SIZE       64
+#endif
+
+// a batch of 8 takes about 1.6ms over fast mode i2c, and draining a full FIFO 6.7ms. Over SPI both take under 1ms
+#ifndef ADX_SAMPLER_TIMEOUT_US
+#define ADX_SAMPLER_TIMEOUT_US      10000
+#endif
+
+// batches that can go by without a WATERMARK interrupt before the sensor is counted as stalled
+#ifndef ADX_SAMPLER_STALL_BATCHES
+#define ADX_SAMPLER_STALL_BATCHES   4
+#endif
+
+// time the ADXL343 needs to pop its FIFO after an entry has been read
+#define ADXL343_FIFO_POP_US         5
+
+// int1_pin of an accelerometer whose INT1 isn't wired to the pico, which has its FIFO polled instead
+#define SAMPLER_NO_PIN              (~0u)
+
+// a sample with the time it was measured
+typedef struct sampler_entry_struct {
+    uint64_t t_us;
+    adxl343_xyz xyz;
+} sampler_entry;
+
+// how the sampling has gone, kept by the sampler's interrupts
+typedef struct sampler_counters_struct {
+    uint32_t batches;           // batches read
+    uint32_t samples;           // samples pushed into the ring
+    uint32_t dropped;           // samples dropped because the ring was full
+    uint32_t timeouts;          // transfers aborted because they took longer than ADX_SAMPLER_TIMEOUT_US
+    uint32_t stalls;            // times ADX_SAMPLER_STALL_BATCHES went by without a batch
+    uint32_t resyncs;           // batches whose times couldn't follow on from the one before
+} sampler_counters;
+
+extern volatile sampler_counters sampler_stats;
+
+
+/*
+Starts sampling accelerometer, which must already be set up with its FIFO streaming and WATERMARK on int1_pin, or
+SAMPLER_NO_PIN to poll the FIFO every watermark samples. Batches of at least watermark samples are read, measured
+sample_period_us apart. Claims two DMA channels, DMA_IRQ_0 and a hardware alarm on the calling core, which the
+WATERMARK interrupt has to be handled on too
+The blocking accelerometer functions must not be used while the sampler runs, see sampler_stop
+
+Returns:
+    PICO_ERROR_NONE: success
+    PICO_ERROR_GENERIC: the watermark is 0, or more than FIFO_CTL can hold (ADXL3XX_FIFO_SAMPLES_MAX)
+*/
+int sampler_init(adxl343 *accelerometer, uint int1_pin, uint watermark, uint32_t sample_period_us);
+
+/*
+Called from the WATERMARK interrupt. Starts reading the batch, or queues it up behind the one being read
+*/
+void sampler_watermark();
+
+/*
+Waits for the transfer in progress, if any, to finish, and stops reading batches, so the blocking accelerometer
+functions can be used. Samples already in the ring can still be popped
+*/
+void sampler_stop();
+
+/*
+Starts reading batches again after sampler_stop, from a FIFO that has been cleared
+*/
+void sampler_start();
+
+/*
+Returns the INT_SOURCE bits read since the last call, and clears them
+*/
+uint8_t sampler_int_source();
+
+/*
+Returns true if there are samples waiting in the ring
+*/
+bool sampler_available();
+
+/*
+Copies the oldest sample in the ring into out, for core 0
+Returns false if the ring was empty
+*/
+bool sampler_pop(sampler_entry *out);
+
+#endif
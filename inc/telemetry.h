@@ -0,0 +1,78 @@
+/*
+Binary telemetry stream for accelerometer captures
+
+Samples are sent over USB CDC in checksummed packets, so a capture can be recorded at the full output data rate and
+decoded without parsing text (see scripts/accelerometer_tests.py). All multi-byte fields are little endian.
+
+    offset  size    field
+    0       2       sync bytes, TELEMETRY_SYNC0 TELEMETRY_SYNC1
+    2       1       TELEMETRY_VERSION
+    3       1       flags, see TELEMETRY_FLAG_
+    4       2       sequence number, incremented for every packet so lost packets can be spotted
+    6       1       n, the number of samples in the packet
+    7       8       time since boot of the first sample, in us
+    15      8 * n   samples: time since the previous sample in us (uint16, 0 for the first), then raw x, y, z (int16)
+    15+8n   2       Fletcher-16 checksum of every byte from the version up to the end of the samples
+
+A sample that is more than 65535us after the one before it starts a new packet.
+
+The accelerometer doesn't timestamp its samples, so the times are the pico's reconstruction: each sample follows the
+one before by the nominal sample period of the data rate. The cadence is only taken up again from the pico's clock
+when samples were lost to a full FIFO, or when it has drifted more than a sample period from the clock, and the
+packet holding the first sample after that is flagged TELEMETRY_FLAG_RESYNC. Its time may jump there, and a jump
+backwards is sent as a delta of 0.
+*/
+#ifndef TELEMETRYH
+#define TELEMETRYH
+
+#include "pico/stdlib.h"
+
+#include "ADXL343.h"
+
+#define TELEMETRY_SYNC0             0xA5
+#define TELEMETRY_SYNC1             0x5A
+#define TELEMETRY_VERSION           1
+
+#define TELEMETRY_FLAG_OVERFLOW     0x01    // the sensor's FIFO filled up before this packet, samples were lost
+#define TELEMETRY_FLAG_RESYNC       0x02    // the sample times were taken up again from the pico's clock in this packet
+
+#define TELEMETRY_HEADER_LEN        15
+#define TELEMETRY_SAMPLE_LEN        8
+#define TELEMETRY_CHECKSUM_LEN      2
+#define TELEMETRY_MAX_SAMPLES       32
+#define TELEMETRY_MAX_PACKET_LEN    (TELEMETRY_HEADER_LEN + TELEMETRY_MAX_SAMPLES * TELEMETRY_SAMPLE_LEN + TELEMETRY_CHECKSUM_LEN)
+
+// a packet being filled with samples
+typedef struct telemetry_packet_struct {
+    uint8_t buf[TELEMETRY_MAX_PACKET_LEN];
+    uint16_t seq;
+    uint8_t n_samples;
+    uint8_t flags;
+    uint64_t prev_us;
+} telemetry_packet;
+
+
+/*
+Starts the first packet of a stream, with sequence number 0
+*/
+void telemetry_init(telemetry_packet *packet);
+
+/*
+Appends a sample read at time t_us to the packet
+Returns -1 if the sample does not fit, in which case the packet must be finished and the sample added again
+*/
+int telemetry_add_sample(telemetry_packet *packet, uint64_t t_us, const adxl343_xyz *sample);
+
+/*
+Or-s flags into the flags of the packet
+*/
+void telemetry_set_flags(telemetry_packet *packet, uint8_t flags);
+
+/*
+Fills in the header and checksum of the packet, and points out at the finished packet
+The packet must be sent before the next sample is added, which starts the next packet
+Returns the length of the packet in bytes, or 0 if it holds no samples
+*/
+size_t telemetry_finish(telemetry_packet *packet, const uint8_t **out);
+
+#endif
@@ -0,0 +1,126 @@
+/*
+Low overhead tracing of the display's hot paths
+
+Each core records timestamped events into a ring of its own, which is drained over USB on demand (the TRACE command,
+see inc/commands.h). Recording an event is a few stores with interrupts briefly off, so it can stay in the interrupt
+handlers and the sensor loop without disturbing the timing it is there to measure, the way a printf would. An event
+that finds its ring full is dropped and counted, and every event is counted by type whether it fit or not.
+
+scripts/trace_histogram.py turns a dump into latency histograms. Tracing compiles to nothing with
+-DLIGHT_WAND_TRACE=0.
+*/
+#ifndef TRACEH
+#define TRACEH
+
+#include "pico/stdlib.h"
+
+#ifndef LIGHT_WAND_TRACE
+#define LIGHT_WAND_TRACE        1
+#endif
+
+// events per core. Must be a power of two
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE         256
+#endif
+
+// there are hundreds of columns per swing, so only the ones that go out at least this late are traced
+#ifndef TRACE_COLUMN_LATE_US
+#define TRACE_COLUMN_LATE_US    20
+#endif
+
+// what each event is, and what its a and b arguments hold
+typedef enum trace_type_enum {
+    TRACE_I2C_READ,         // a: samples read from the accelerometer, b: time the read took in us
+    TRACE_REVERSAL,         // a: new display direction, b: seq of the swing signalled, 0 if it was already anticipated
+    TRACE_ANTICIPATE,       // a: display direction of the swing, b: its seq
+    TRACE_SWING_DROP,       // a: 0, b: seq of a swing dropped because the ring to core 1 was full
+    TRACE_DOORBELL_SKIP,    // a: 0, b: seq of a swing whose doorbell was skipped because the FIFO was full
+    TRACE_SWING_START,      // a: columns the swing was given, b: its seq
+    TRACE_SWING_END,        // a: columns shown, b: columns given, when the last column of a swing has gone out
+    TRACE_COLUMN_LATE,      // a: column of the swing, b: how late it went out in us
+    TRACE_COLUMN_SKIP,      // a: columns skipped in a row because they were already due, b: how late the first was in us
+    TRACE_COLUMN_DROPPED,   // a: column dropped because the one before was still going out, b: how late it was in us
+    TRACE_OVERRUN,          // a: columns shown, b: columns cut, of a swing replaced before it had finished
+    TRACE_SAMPLER_TIMEOUT,  // a: entries read over SPI, 0 over i2c, b: how long the aborted transfer had been running in us
+    TRACE_SAMPLER_STALL,    // a: level of the WATERMARK pin (0 when polled), b: 0, when no batch has been signalled for a
+                            // while, or a poll found the FIFO empty
+    TRACE_IDLE,             // a: 1 going idle, 0 waking up, b: on waking, how long the wand was idle in ms, not
+                            // counting any time dormant
+    TRACE_N_TYPES
+} trace_type;
+
+typedef struct trace_event_struct {
+    uint32_t t_us;          // low 32 bits of the time since boot
+    uint16_t type;
+    uint16_t a;
+    uint32_t b;
+} trace_event;
+
+/*
+Ring of the events recorded on one core
+The core records into head, dropped and counts, and the TRACE command drains tail, from whichever core it runs on.
+Clearing only moves the command's end too: tail, and the baselines the counters are reported from
+*/
+typedef struct trace_ring_struct {
+    trace_event events[TRACE_RING_SIZE];
+    volatile uint32_t head;
+    volatile uint32_t tail;
+    volatile uint32_t dropped;
+    volatile uint32_t counts[TRACE_N_TYPES];
+    uint32_t dropped_base;      // dropped and counts as they were at the last trace_clear
+    uint32_t counts_base[TRACE_N_TYPES];
+} trace_ring;
+
+// one ring per core
+extern trace_ring trace_rings[2];
+
+#if LIGHT_WAND_TRACE
+#define TRACE(type, a, b)       trace_record((type), (a), (b))
+#else
+#define TRACE(type, a, b)       ((void)0)
+#endif
+
+
+/*
+Records an event into the ring of the calling core. Safe to call from interrupt handlers. Use TRACE instead, so the
+call disappears when tracing is compiled out
+*/
+void trace_record(trace_type type, uint16_t a, uint32_t b);
+
+/*
+Copies the oldest event in ring into out
+Returns false if the ring was empty
+*/
+bool trace_pop(trace_ring *ring, trace_event *out);
+
+/*
+Returns the name an event type is dumped under
+*/
+const char *trace_type_name(trace_type type);
+
+/*
+Returns the events of a type recorded on core since the last trace_clear
+*/
+uint32_t trace_count(int core, trace_type type);
+
+/*
+Empties both rings, and clears their counters. Safe while either core records
+*/
+void trace_clear();
+
+/*
+Prints every event waiting in both rings, oldest first, draining the rings:
+
+    EV <core> <t_us> <type> <a> <b>
+*/
+void trace_dump_events();
+
+/*
+Prints the counters of both rings, then drains their events with trace_dump_events:
+
+    COUNT <core> <type> <n>
+    DROPPED <core> <n>
+*/
+void trace_dump();
+
+#endif
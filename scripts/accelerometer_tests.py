@@ -4,10 +4,13 @@ A tool for acquiring accelerometer data and plotting/modeling it
 To acquire data:
 1. Flash the pico with the accelerometer_data.uf2 program
 2. Plug in the wand with its battery removed
-3. Run this program in data acquisition mode
+3. Run this program in data acquisition mode, with a .bin data_path
 
 To plot data:
-1. Run this program in plot mode
+1. Run this program in plot mode, with either a .bin capture or a .csv one (from older captures or
+   generate_swing_capture.py)
+
+Binary captures can be converted into the csv format the simulator replays with --export_csv
 """
 
 import argparse
@@ -16,6 +19,82 @@ import numpy as np
 from matplotlib import pyplot as plt
 from pathlib import Path
 
+ADXL3XXVAL_TO_MSS = 1.0 / 511.0 * 156.9064  # 16G range, see inc/ADXL343.h
+
+# binary telemetry packets, see inc/telemetry.h
+TELEMETRY_SYNC = b"\xa5\x5a"
+TELEMETRY_VERSION = 1
+TELEMETRY_FLAG_OVERFLOW = 0x01
+TELEMETRY_FLAG_RESYNC = 0x02
+TELEMETRY_HEADER = np.dtype([("version", "u1"), ("flags", "u1"), ("seq", "<u2"), ("n", "u1"), ("t0_us", "<u8")])
+TELEMETRY_SAMPLE = np.dtype([("dt_us", "<u2"), ("x", "<i2"), ("y", "<i2"), ("z", "<i2")])
+
+
+def fletcher16(data: bytes):
+    """Returns the Fletcher-16 checksum of data as (sum1, sum2)"""
+
+    # sum2 adds up every running sum1, which is the same as weighting each byte by how many running sums it is in
+    d = np.frombuffer(data, dtype=np.uint8).astype(np.int64)
+    weights = np.arange(len(d), 0, -1, dtype=np.int64)
+    return int(d.sum() % 255), int((d * weights).sum() % 255)
+
+
+def decode_telemetry(raw: bytes):
+    """
+    Decodes a binary capture from the accelerometer_data target
+    Returns the time of each sample in us and a structured array of raw x, y, z counts. Corrupt packets are skipped,
+    and any samples lost (to bad packets, dropped packets or an overflowing sensor FIFO) are reported, as are the
+    places the sample times were taken up again from the pico's clock after the first.
+    """
+
+    times, samples = [], []
+    prev_seq = None
+    pos = raw.find(TELEMETRY_SYNC)
+    n_bad = n_lost_packets = n_overflows = n_resyncs = 0
+
+    while 0 <= pos and pos + 2 + TELEMETRY_HEADER.itemsize <= len(raw):
+        header = np.frombuffer(raw, dtype=TELEMETRY_HEADER, count=1, offset=pos + 2)[0]
+        body_end = pos + 2 + TELEMETRY_HEADER.itemsize + int(header["n"]) * TELEMETRY_SAMPLE.itemsize
+
+        if header["version"] != TELEMETRY_VERSION or header["n"] == 0 or body_end + 2 > len(raw) or \
+                fletcher16(raw[pos + 2:body_end]) != tuple(raw[body_end:body_end + 2]):
+            # not a packet, or a damaged one. Look for the next sync bytes
+            n_bad += 1
+            pos = raw.find(TELEMETRY_SYNC, pos + 1)
+            continue
+
+        seq = int(header["seq"])
+        if prev_seq is not None and seq != (prev_seq + 1) % 65536:
+            n_lost_packets += (seq - prev_seq - 1) % 65536
+        prev_seq = seq
+        if header["flags"] & TELEMETRY_FLAG_OVERFLOW:
+            n_overflows += 1
+        if header["flags"] & TELEMETRY_FLAG_RESYNC and times:
+            n_resyncs += 1
+
+        block = np.frombuffer(raw, dtype=TELEMETRY_SAMPLE, count=int(header["n"]), offset=pos + 2 + TELEMETRY_HEADER.itemsize)
+        times.append(header["t0_us"] + np.cumsum(block["dt_us"], dtype=np.uint64))
+        samples.append(block[["x", "y", "z"]])
+        pos = raw.find(TELEMETRY_SYNC, body_end + 2)
+
+    if n_bad or n_lost_packets or n_overflows or n_resyncs:
+        print(f"Warning: {n_bad} corrupt packets, {n_lost_packets} lost packets, {n_overflows} sensor FIFO overflows, "
+              f"{n_resyncs} sample time resyncs")
+    if not times:
+        raise Exception("No telemetry packets found")
+
+    return np.concatenate(times), np.concatenate(samples)
+
+
+def load_capture(path: Path):
+    """Loads a .bin or .csv capture, returning an array of [x acceleration in m/s^2, time since boot in us] rows"""
+
+    if path.suffix == ".bin":
+        times, samples = decode_telemetry(path.read_bytes())
+        return np.column_stack((samples["x"] * ADXL3XXVAL_TO_MSS, times.astype(np.double)))
+
+    return np.loadtxt(path, delimiter=',', skiprows=1, dtype=np.double)
+
 
 def calc_direction_from_jerk(jerks: np.array):
     """Calculates the direction implied by the jerk of the wand"""
@@ -55,26 +134,33 @@ def hysteresize_direction(dirs: np.array, hyst_len: int):
 if __name__ == "__main__":
     parser = argparse.ArgumentParser(description=DESCRIPTION, formatter_class=argparse.RawDescriptionHelpFormatter)
     parser.add_argument("com_port", type=str, help="The COM port the wand is plugged into")
-    parser.add_argument("data_path", type=Path, help="The path to a csv file store/load data from")
+    parser.add_argument("data_path", type=Path, help="The path to a .bin (or .csv, for plotting) file store/load data from")
     parser.add_argument("--data_mode", default=False, action='store_true', help="Data acquire mode")
+    parser.add_argument("--export_csv", type=Path, default=None, help="Convert the capture to csv for the simulator and exit")
     parser.add_argument("--ptime_start", type=float, default=0, help="The time in seconds to start plotting from")
     parser.add_argument("--ptime_end", type=float, default=-1, help="The time in seconds to end plotting at")
 
     args = parser.parse_args()
     print(args)
 
-    assert args.data_path.suffix == ".csv", "data_path must be a csv file"
+    assert args.data_path.suffix in (".bin", ".csv"), "data_path must be a bin or csv file"
+    assert not args.data_mode or args.data_path.suffix == ".bin", "captures are recorded as bin files"
 
-    if args.data_mode == False:
-        # Open the csv file at data_path and plot the data in matplotlib
+    if args.export_csv is not None:
+        data = load_capture(args.data_path)
+        np.savetxt(args.export_csv, data, fmt=["%f", "%d"], delimiter=",", header="Acceleration (mss), Time since boot (us)", comments="")
+        print(f"Wrote {len(data)} samples to {args.export_csv}")
+
+    elif args.data_mode == False:
+        # Open the capture at data_path and plot the data in matplotlib
         if not args.data_path.exists():
-            raise Exception(f"Could not find a csv file at {args.data_path}")
+            raise Exception(f"Could not find a capture at {args.data_path}")
         
         start = args.ptime_start * 1_000_000
         end = args.ptime_end * 1_000_000 if args.ptime_end >= 0 else np.inf
 
         # plot accel from start to end
-        data = np.loadtxt(args.data_path, delimiter=',', skiprows=1, dtype=np.double)
+        data = load_capture(args.data_path)
 
         print(f"Loaded data parameters:\n\tstart time: {data[0, -1] / 1_000_000}s\n\tend time: {data[-1, -1] / 1_000_000}s")
 
@@ -125,16 +211,16 @@ if __name__ == "__main__":
         plt.show()
 
     else:
-        # Open the com port and start polling for data
-        with serial.Serial(args.com_port, baudrate=115200, timeout=10) as ser:
-            # Clear the data file / write header
-            with open(args.data_path, 'w') as f:
-                f.write("Acceleration (mss), Time since boot (us)")
-
+        # Open the com port and record the raw stream. It is only decoded when loaded, so nothing is lost to parsing
+        with serial.Serial(args.com_port, baudrate=115200, timeout=1) as ser:
             print("Acquiring data from the wand... Ctrl+C to finish")
 
-            # Open the data file and start polling / appending
-            with open(args.data_path, 'a') as f:
-                while True:
-                    m = ser.readline().decode('utf-8')[:-1] # decode and strip newline
-                    f.write(m)
+            with open(args.data_path, 'wb') as f:
+                try:
+                    while True:
+                        f.write(ser.read(max(1, ser.in_waiting)))
+                except KeyboardInterrupt:
+                    pass
+
+        times, samples = decode_telemetry(args.data_path.read_bytes())
+        print(f"Captured {len(times)} samples over {(times[-1] - times[0]) / 1_000_000:.2f}s")
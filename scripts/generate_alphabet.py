@@ -1,110 +1,121 @@
-# Script that generates the alphabet.h file that is used to provide a 
+# Script that generates the font atlas (src/font_atlas.c) that is used to provide a 
 #   representation of characters for the light wand to display
+#
+# Every printable ASCII character, plus any --extra characters, is rendered from a true type font and trimmed to
+# its own width. The glyphs' columns are packed back to back into one array of 16-bit columns, with a table of
+# where each glyph starts and how wide it is, and lookup tables from characters to glyphs. See inc/font.h.
+#
+# The build runs this when LIGHT_WAND_FONT is set (see CMakeLists.txt), otherwise the checked in atlas is used.
 
 from pathlib import Path
 from PIL import Image, ImageFont, ImageDraw
 import numpy as np
 import argparse
 
-SOURCE_DIR = Path("./alphabet_source")
-CHAR_WIDTH = 15
-CHAR_HEIGHT = 15
-
-ALPHABET = {
-    'A': 'A',
-    'B': 'B',
-    'C': 'C',
-    'D': 'D',
-    'E': 'E',
-    'F': 'F',
-    'G': 'G',
-    'H': 'H',
-    'I': 'I',
-    'J': 'J',
-    'K': 'K',
-    'L': 'L',
-    'M': 'M',
-    'N': 'N',
-    'O': 'O',
-    'P': 'P',
-    'Q': 'Q',
-    'R': 'R',
-    'S': 'S',
-    'T': 'T',
-    'U': 'U',
-    'V': 'V',
-    'W': 'W',
-    'X': 'X',
-    'Y': 'Y',
-    'Z': 'Z',
-    'BANG': '!',
-    'QUESTION': '?',
-    'PERIOD': '.',
-    'COMMA': ',',
-}
+CHAR_HEIGHT = 15        # must match FONT_HEIGHT in inc/font.h
+SPACE_MIN_WIDTH = 3
+FALLBACK = '?'
+
+ASCII_PRINTABLE = [chr(c) for c in range(0x20, 0x7f)]
+
+
+def render_glyph(font, char, xoff, yoff, threshold, show):
+    """Renders char and returns its 16-bit columns, trimmed of blank columns on either side"""
+
+    # render onto a canvas wider than any glyph, so nothing is clipped before it is trimmed
+    width = CHAR_HEIGHT * 3
+    image = Image.new('L', size=(width, CHAR_HEIGHT))
+    draw = ImageDraw.Draw(image)
+    draw.text((xoff, yoff), char, font=font, fill=255)
+
+    if show:
+        image.show()
+
+    # convert the image to an array of ones and zeroes, 1 where the character was drawn
+    imarray = (np.asarray(image) >= threshold).astype(np.uint16)
+
+    # now extract the vertical columns of the image and turn them into 16-bit bitfields. The top row of the image
+    # is the LSB, which is the lowest pixel on the wand as it is held
+    weights = (1 << np.arange(CHAR_HEIGHT)).astype(np.uint16)
+    columns = (imarray * weights[:, None]).sum(axis=0).astype(np.uint16)
+
+    inked = np.nonzero(columns)[0]
+    if len(inked) == 0:
+        # blank characters (the space) still take up room
+        advance = max(SPACE_MIN_WIDTH, round(font.getlength(char)))
+        return [0] * advance
+    return [int(c) for c in columns[inked[0]:inked[-1] + 1]]
+
+
+def c_array(values, per_line, fmt):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join(fmt.format(v) for v in values[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
 
 if __name__ == "__main__":
     parser = argparse.ArgumentParser()
     parser.add_argument('font_path', type=Path, help="Path to the true type font (.tff) font to generate the light wand font from")
-    parser.add_argument('xoff', type=int, help="Character offset in X direction")
-    parser.add_argument('yoff', type=int, help="Character offset in Y direction")
-    parser.add_argument('font_size', type=int, help="Character font size")
+    parser.add_argument('xoff', type=int, nargs='?', default=1, help="Character offset in X direction")
+    parser.add_argument('yoff', type=int, nargs='?', default=-3, help="Character offset in Y direction")
+    parser.add_argument('font_size', type=int, nargs='?', default=15, help="Character font size")
+    parser.add_argument('--threshold', type=int, default=110, help="Grey level (0-255) at which a pixel is lit")
+    parser.add_argument('--extra', type=str, default="°", help="Non-ASCII characters to include in the atlas")
+    parser.add_argument('--output', type=Path, default=None, help="Where to write the atlas, printed if not given")
     parser.add_argument('--show', action='store_true', help="If set, this flag causes each character image to be shown during generation")
 
     args = parser.parse_args()
 
-    print("Generating alphabet...")
+    font = ImageFont.truetype(str(args.font_path), args.font_size)
+    chars = ASCII_PRINTABLE + sorted(set(args.extra) - set(ASCII_PRINTABLE))
 
-    generated_c = """
-/*
-Generated by scripts/generate_alphabet.py
+    columns = []
+    glyphs = []
+    for char in chars:
+        glyph_columns = render_glyph(font, char, args.xoff, args.yoff, args.threshold, args.show)
+        glyphs.append((len(columns), len(glyph_columns), char))
+        columns += glyph_columns
 
-This h file contains generated representations for characters to be dispalyed on the light wand as arrays of 32-bit integers
-Each 32-bit integer in an array is a column of the characer, and each bit in that integer is a pixel. 1's mean on, 0's mean off.
+    assert len(columns) < 1 << 16, "too many columns for 16-bit glyph offsets"
+    assert max(w for _, w, _ in glyphs) < 1 << 8, "glyphs too wide for 8-bit widths"
 
-The lowest pixel on the wand is the LSB
+    # ASCII characters are looked up directly, anything else by binary search of the sorted extra code points
+    index = {char: i for i, (_, _, char) in enumerate(glyphs)}
+    ascii_lookup = [index.get(chr(c), index[FALLBACK]) for c in range(128)]
+    extras = sorted((ord(char), i) for i, (_, _, char) in enumerate(glyphs) if ord(char) >= 128)
 
+    generated_c = f"""/*
+Generated by scripts/generate_alphabet.py from {args.font_path.name} (size {args.font_size}, offset {args.xoff},{args.yoff})
+Do not edit by hand, see inc/font.h for the layout
 */
 
+#include "font.h"
+
+#if FONT_N_COLUMNS != {len(columns)} || FONT_N_GLYPHS != {len(glyphs)} || FONT_N_EXTRAS != {len(extras)}
+#error "inc/font.h does not match the generated atlas, update FONT_N_COLUMNS, FONT_N_GLYPHS and FONT_N_EXTRAS"
+#endif
+
+const uint16_t font_columns[FONT_N_COLUMNS] = {{
+{c_array(columns, 12, "0x{:04x}")}
+}};
+
+const font_glyph font_glyphs[FONT_N_GLYPHS] = {{
+{chr(10).join(f"    {{{offset:4d}, {width:2d}}},   // {ascii(char)}" for offset, width, char in glyphs)}
+}};
+
+const uint8_t font_ascii[128] = {{
+{c_array(ascii_lookup, 16, "{:3d}")}
+}};
+
+const font_extra_glyph font_extras[FONT_N_EXTRAS] = {{
+{chr(10).join(f"    {{0x{cp:04x}, {i:3d}}},   // U+{cp:04X}" for cp, i in extras)}
+}};
 """
-    generated_c += "#include <stdint.h>\n\n"
-    generated_c += f"#define\tCHAR_WIDTH\t{CHAR_WIDTH}\n#define\tCHAR_HEIGHT\t{CHAR_HEIGHT}\n\n"
-
-    for char_name in list(ALPHABET.keys()):
-        image = Image.new('L', size=(CHAR_WIDTH, CHAR_HEIGHT))
-        draw = ImageDraw.Draw(image)
-
-        font = ImageFont.truetype(str(args.font_path), args.font_size)
-        draw.text((args.xoff, args.yoff), ALPHABET[char_name], font=font, fill=255)
-
-        print(args.show)
-        if args.show:
-            image.show()
-
-        # convert the image to a grayscale array of ones and zeroes.
-        imarray = np.asarray(image) / 255
-        imarray = np.around(imarray, decimals=0)
-        inverter = np.ones_like(imarray)
-        imarray = inverter - imarray
-
-        print(imarray)
-            
-        # now extract the vertical columns of the image and turn them into 32-bit bitfields
-        integers = np.zeros(CHAR_WIDTH, dtype="uint32")
-        for col in range(CHAR_WIDTH):
-            column = imarray[:, col]
-
-            for i, bit in enumerate(column):
-                integers[col] = integers[col] | ((not int(bit)) << i)
-
-        generated_c += f"const uint32_t CHAR_{char_name}[CHAR_WIDTH]\t= "
-        generated_c += "{"
-        for i in integers:
-            generated_c += f"0x{i:08x},"
-
-        generated_c = generated_c[:-1]
-        generated_c = generated_c + "};\n"
-
-    print("Copy and paste the following code into alphabet.h:")
-    print()
-    print(generated_c)
\ No newline at end of file
+
+    if args.output is None:
+        print(generated_c)
+    else:
+        # the rest of the sources have windows line endings
+        args.output.write_text(generated_c, newline='\r\n')
+        print(f"Wrote {len(glyphs)} glyphs, {len(columns)} columns to {args.output}")
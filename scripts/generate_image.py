@@ -0,0 +1,155 @@
+# Script that generates the built in images (src/images.c) that the light wand can display, see inc/image.h
+#
+# Every frame of every image (GIFs are animations) is scaled to the height of the wand, and the colours of the whole
+# image are reduced to a shared palette of at most 16 colours. The frames are then run length encoded column after
+# column, which is the order core 1 decodes them in.
+#
+# Usage: python generate_image.py heart.png spinner.gif --output ../src/images.c
+# The images are named after their files, and are shown with the IMG command (see inc/commands.h).
+
+from pathlib import Path
+from PIL import Image, ImageSequence
+import numpy as np
+import argparse
+
+MAX_COLORS = 16         # IMAGE_MAX_COLORS in inc/image.h
+RUN_MAX = 16            # IMAGE_RUN_MAX in inc/image.h
+
+
+def load_frames(path, height, max_width):
+    """Returns every frame of the image as an RGB array, scaled to height pixels and at most max_width columns"""
+
+    frames = []
+    with Image.open(path) as image:
+        width = max(1, round(image.width * height / image.height))
+        width = min(width, max_width)
+        for frame in ImageSequence.Iterator(image):
+            frame = frame.convert('RGB').resize((width, height), Image.Resampling.LANCZOS)
+            frames.append(np.asarray(frame))
+    return frames
+
+
+def quantize(frames, n_colors):
+    """Reduces the frames to one shared palette. Returns the palette and the palette index of every pixel"""
+
+    # quantize all the frames at once, stacked on top of each other, so they share the palette
+    stacked = Image.fromarray(np.concatenate(frames, axis=0))
+    quantized = stacked.quantize(colors=n_colors, method=Image.Quantize.MEDIANCUT, dither=Image.Dither.NONE)
+    indices = np.asarray(quantized)
+
+    used = int(indices.max()) + 1
+    palette = np.array(quantized.getpalette()[:used * 3], dtype=np.int32).reshape(used, 3)
+    return palette, np.split(indices, len(frames), axis=0)
+
+
+def rgb_to_rgbw(palette, brightness):
+    """Moves the grey part of every colour onto the white LED, and dims the colours by brightness"""
+
+    white = palette.min(axis=1, keepdims=True)
+    rgbw = np.concatenate([palette - white, white], axis=1)
+    return np.round(rgbw * brightness).astype(np.uint8)
+
+
+def encode_frame(indices):
+    """Run length encodes a frame, column after column. The top row of the image is pixel 0, as in the font"""
+
+    runs = []
+    pixels = indices.T.flatten()
+    i = 0
+    while i < len(pixels):
+        n = 1
+        while n < RUN_MAX and i + n < len(pixels) and pixels[i + n] == pixels[i]:
+            n += 1
+        runs.append(((n - 1) << 4) | int(pixels[i]))
+        i += n
+    return runs
+
+
+def c_array(values, per_line, fmt):
+    lines = []
+    for i in range(0, len(values), per_line):
+        lines.append("    " + ", ".join(fmt.format(v) for v in values[i:i + per_line]) + ",")
+    return "\n".join(lines)
+
+
+def c_image(name, frames, height, n_colors, brightness):
+    palette, indices = quantize(frames, n_colors)
+    rgbw = rgb_to_rgbw(palette, brightness)
+
+    data = []
+    offsets = []
+    for frame in indices:
+        offsets.append(len(data))
+        data += encode_frame(frame)
+
+    width = frames[0].shape[1]
+    raw = width * height * 4 * len(frames)
+    print(f"{name}: {width}x{height}, {len(frames)} frames, {len(rgbw)} colours, {len(data)} bytes ({raw} uncompressed)")
+
+    return f"""static const image_color {name}_palette[] = {{
+{chr(10).join(f"    {{{r:3d}, {g:3d}, {b:3d}, {w:3d}}}," for r, g, b, w in rgbw)}
+}};
+
+static const uint32_t {name}_frames[] = {{
+{c_array(offsets, 8, "{:6d}")}
+}};
+
+static const uint8_t {name}_data[] = {{
+{c_array(data, 16, "0x{:02x}")}
+}};
+
+static const image {name}_image = {{
+    .name = "{name}",
+    .width = {width},
+    .height = {height},
+    .n_frames = {len(frames)},
+    .n_colors = {len(rgbw)},
+    .palette = {name}_palette,
+    .frames = {name}_frames,
+    .data = {name}_data,
+}};
+"""
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser()
+    parser.add_argument('image_paths', type=Path, nargs='+', help="Images to include, GIFs are played one frame per swing")
+    parser.add_argument('--height', type=int, default=15, help="Pixels per column, WS2812_COLUMN_PIXELS in inc/neopixels.h")
+    parser.add_argument('--max_width', type=int, default=200, help="Most columns an image can take, N_DISPLAY_COLUMNS in inc/pov.h")
+    parser.add_argument('--colors', type=int, default=MAX_COLORS, help="Most colours in the palette of an image")
+    parser.add_argument('--brightness', type=float, default=1.0, help="Scales every colour, 0-1")
+    parser.add_argument('--output', type=Path, help="Path to write the C file to, otherwise it is printed")
+
+    args = parser.parse_args()
+    assert 1 <= args.colors <= MAX_COLORS, f"at most {MAX_COLORS} colours"
+
+    names = []
+    sources = []
+    for path in args.image_paths:
+        name = path.stem.replace('-', '_').replace(' ', '_')
+        assert name.isidentifier(), f"{path} does not make a C identifier"
+        frames = load_frames(path, args.height, args.max_width)
+        sources.append(c_image(name, frames, args.height, args.colors, args.brightness))
+        names.append(name)
+
+    generated_c = f"""/*
+Generated by scripts/generate_image.py from {", ".join(p.name for p in args.image_paths)}
+Do not edit by hand, see inc/image.h for the format
+*/
+
+#include "image.h"
+
+{chr(10).join(sources)}
+const image *const images[] = {{
+{chr(10).join(f"    &{name}_image," for name in names)}
+}};
+
+const int n_images = {len(names)};
+"""
+
+    if args.output is None:
+        print(generated_c)
+    else:
+        # the rest of the sources have windows line endings
+        args.output.write_text(generated_c, newline='\r\n')
+        print(f"Wrote {len(names)} images to {args.output}")
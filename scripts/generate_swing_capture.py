@@ -0,0 +1,79 @@
+DESCRIPTION = """
+Generates synthetic accelerometer captures for the light wand simulator (sim/)
+
+The wand is modelled as swinging harmonically, with a swing frequency that ramps linearly from freq_start to
+freq_end. The acceleration is sampled the way the firmware sees it: the ADXL343 updates its output at odr Hz,
+and core 0 reads it every ~630us, so most reads return a repeat of the previous value.
+
+With --data_ready, the capture is instead sampled the way the firmware sees it when it waits for the DATA_READY
+interrupt: exactly one read per output data period.
+
+The output has the same format as captures from the accelerometer_data target, so it can be plotted with
+accelerometer_tests.py and replayed with light-wand-sim.
+"""
+
+import argparse
+import math
+import random
+from pathlib import Path
+
+ADXL3XXVAL_TO_MSS = 1.0 / 511.0 * 156.9064  # 16G range, see inc/ADXL343.h
+ADXL3XXVAL_MAX = 511
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=DESCRIPTION, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("data_path", type=Path, help="The path to the csv file to write")
+    parser.add_argument("--duration", type=float, default=6.0, help="Length of the capture in seconds")
+    parser.add_argument("--rest", type=float, default=0.5, help="Time in seconds the wand rests before swinging")
+    parser.add_argument("--freq_start", type=float, default=1.6, help="Full swing frequency at the start, in Hz")
+    parser.add_argument("--freq_end", type=float, default=1.6, help="Full swing frequency at the end, in Hz")
+    parser.add_argument("--amplitude", type=float, default=0.3, help="Distance from the center to the end of a swing, in meters")
+    parser.add_argument("--odr", type=float, default=100, help="Output data rate of the accelerometer in Hz")
+    parser.add_argument("--read_us", type=int, default=630, help="Average time core 0 takes to read a sample in us")
+    parser.add_argument("--data_ready", default=False, action='store_true', help="Read once per output data period")
+    parser.add_argument("--noise", type=float, default=1.0, help="Standard deviation of the sensor noise in raw counts")
+    parser.add_argument("--seed", type=int, default=1, help="Random seed, so captures are reproducible")
+
+    args = parser.parse_args()
+    assert args.data_path.suffix == ".csv", "data_path must be a csv file"
+
+    rng = random.Random(args.seed)
+    boot_offset_us = 5_000_000
+    t_us = 0
+    phase = 0.0
+    prev_t_us = 0
+    odr_period_us = 1_000_000 / args.odr
+    held_raw = 0
+    held_update = -1
+
+    with open(args.data_path, 'w') as f:
+        f.write("Acceleration (mss), Time since boot (us)\n")
+
+        while t_us < args.duration * 1_000_000:
+            t = t_us / 1_000_000
+
+            # integrate the phase so the frequency ramp doesn't make the swing jump
+            swing_t = max(0.0, t - args.rest)
+            progress = swing_t / max(args.duration - args.rest, 1e-6)
+            freq = args.freq_start + (args.freq_end - args.freq_start) * progress
+            if t > args.rest:
+                phase += 2 * math.pi * freq * (t_us - prev_t_us) / 1_000_000
+
+            # the sensor only produces a new value once per output data period
+            update = int(t_us // odr_period_us)
+            if update != held_update:
+                omega = 2 * math.pi * freq
+                accel_mss = -args.amplitude * omega * omega * math.sin(phase) if t > args.rest else 0.0
+                raw = round(accel_mss / ADXL3XXVAL_TO_MSS + rng.gauss(0, args.noise))
+                held_raw = max(-ADXL3XXVAL_MAX, min(ADXL3XXVAL_MAX, raw))
+                held_update = update
+
+            f.write(f"{held_raw * ADXL3XXVAL_TO_MSS:f},{boot_offset_us + t_us}\n")
+
+            prev_t_us = t_us
+            if args.data_ready:
+                t_us = int((update + 1) * odr_period_us) + rng.randint(0, 3)
+            else:
+                t_us += args.read_us + rng.randint(-20, 50)
+
+    print(f"Wrote {args.data_path}")
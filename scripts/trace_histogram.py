@@ -0,0 +1,129 @@
+DESCRIPTION = """
+Turns a dump of the wand's trace rings (see inc/trace.h) into latency histograms
+
+To take a dump from the wand, give the COM port it is plugged into. The TRACE command is sent, and everything up to
+its OK is read. With --repeat the rings are drained again every that many seconds until Ctrl+C, so a longer stretch
+than the rings hold can be collected.
+
+A dump can also be read from a file, e.g. one saved with --save, or the output of the simulator run with -t.
+"""
+
+import argparse
+import time
+import numpy as np
+from pathlib import Path
+
+# the bins every histogram is split into, in us
+BINS_US = [0, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 20000, 50000, 100000]
+BAR_WIDTH = 50
+
+
+def read_dump(port, repeat):
+    """Sends TRACE to the wand and returns the lines of the reply, draining it every repeat seconds if given"""
+
+    import serial
+
+    lines = []
+    with serial.Serial(port, baudrate=115200, timeout=2) as ser:
+        try:
+            while True:
+                ser.write(b"TRACE\n")
+                while True:
+                    line = ser.readline().decode(errors="replace").strip()
+                    if line == "" or line == "OK":
+                        break
+                    lines.append(line)
+                if repeat is None:
+                    break
+                time.sleep(repeat)
+        except KeyboardInterrupt:
+            pass
+    return lines
+
+
+def parse(lines):
+    """Returns the counters as {(core, type): n}, the drops as {core: n}, and the events as a list of
+    (core, t_us, type, a, b). The counters of the last dump win, as they are running totals"""
+
+    counts, dropped, events = {}, {}, []
+    for line in lines:
+        fields = line.split()
+        if len(fields) == 4 and fields[0] == "COUNT":
+            counts[(int(fields[1]), fields[2])] = int(fields[3])
+        elif len(fields) == 3 and fields[0] == "DROPPED":
+            dropped[int(fields[1])] = int(fields[2])
+        elif len(fields) == 6 and fields[0] == "EV":
+            events.append((int(fields[1]), int(fields[2]), fields[3], int(fields[4]), int(fields[5])))
+    return counts, dropped, events
+
+
+def swing_start_latency(events):
+    """Returns how long after core 0 signalled each swing core 1 started it, in us"""
+
+    signalled = {}
+    latencies = []
+    for core, t_us, kind, a, b in events:
+        if kind in ("REVERSAL", "ANTICIPATE") and b != 0:
+            signalled[b] = t_us
+        elif kind == "SWING_START" and b in signalled:
+            # the timestamps are the low 32 bits of the time since boot
+            latencies.append((t_us - signalled.pop(b)) % (1 << 32))
+    return latencies
+
+
+def print_histogram(title, values_us):
+    print(f"\n{title}: {len(values_us)} events", end="")
+    if len(values_us) == 0:
+        print()
+        return
+
+    values = np.array(values_us)
+    print(f", mean {values.mean():.1f}us, p50 {np.percentile(values, 50):.0f}us, p99 {np.percentile(values, 99):.0f}us, "
+          f"max {values.max()}us")
+
+    # anything past the last bin goes into it
+    hist, _ = np.histogram(np.minimum(values, BINS_US[-1]), bins=BINS_US + [BINS_US[-1] + 1])
+    scale = BAR_WIDTH / max(hist.max(), 1)
+    for lo, n in zip(BINS_US, hist):
+        print(f"  >= {lo:6d}us {n:7d} {'#' * int(round(n * scale))}")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=DESCRIPTION, formatter_class=argparse.RawDescriptionHelpFormatter)
+    source = parser.add_mutually_exclusive_group(required=True)
+    source.add_argument("--port", type=str, help="The COM port the wand is plugged into")
+    source.add_argument("--dump", type=Path, help="A saved dump to read instead")
+    parser.add_argument("--repeat", type=float, default=None, help="Drain the rings every this many seconds until Ctrl+C")
+    parser.add_argument("--save", type=Path, default=None, help="Also save the raw dump to this file")
+
+    args = parser.parse_args()
+
+    if args.port is not None:
+        lines = read_dump(args.port, args.repeat)
+    else:
+        lines = args.dump.read_text().splitlines()
+    if args.save is not None:
+        args.save.write_text("\n".join(lines) + "\n")
+
+    counts, dropped, events = parse(lines)
+
+    print("Counters (core 0, core 1):")
+    for kind in dict.fromkeys(k for _, k in counts):
+        print(f"  {kind:14s} {counts.get((0, kind), 0):8d} {counts.get((1, kind), 0):8d}")
+    for core, n in sorted(dropped.items()):
+        if n > 0:
+            print(f"  core {core} dropped {n} events, its ring was full. Dump more often to catch them")
+
+    def b_of(kind):
+        return [b for _, _, k, _, b in events if k == kind]
+
+    print_histogram("Accelerometer batch read time", b_of("I2C_READ"))
+    print_histogram("Swing start, from core 0 signalling it to core 1 starting it", swing_start_latency(events))
+    print_histogram("Column lateness, of columns at least TRACE_COLUMN_LATE_US late", b_of("COLUMN_LATE"))
+    print_histogram("Lateness of the first of a run of skipped columns", b_of("COLUMN_SKIP"))
+    print_histogram("Lateness of columns dropped behind the one before", b_of("COLUMN_DROPPED"))
+
+    overruns = [(a, b) for _, _, k, a, b in events if k == "OVERRUN"]
+    if overruns:
+        cut = np.array([b for _, b in overruns])
+        print(f"\nOverruns: {len(overruns)}, {cut.mean():.1f} columns cut on average, {cut.max()} at most")
@@ -0,0 +1,9 @@
+/*
+Stand-in for the Pico SDK header of the same name, used by the host-side simulator
+*/
+#ifndef SIM_HARDWARE_CLOCKS_H
+#define SIM_HARDWARE_CLOCKS_H
+
+#include "pico/stdlib.h"
+
+#endif
@@ -0,0 +1,47 @@
+/*
+Stand-in for the Pico SDK header of the same name, used by the host-side simulator
+There are no pins to drive, so these do nothing
+*/
+#ifndef SIM_HARDWARE_GPIO_H
+#define SIM_HARDWARE_GPIO_H
+
+#include "pico/stdlib.h"
+
+#define GPIO_OUT    1
+#define GPIO_IN     0
+
+enum gpio_function {
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_SIO = 5,
+};
+
+static inline void gpio_init(uint gpio)
+{
+    (void)gpio;
+}
+
+static inline void gpio_set_dir(uint gpio, bool out)
+{
+    (void)gpio;
+    (void)out;
+}
+
+static inline void gpio_put(uint gpio, bool value)
+{
+    (void)gpio;
+    (void)value;
+}
+
+static inline void gpio_set_function(uint gpio, enum gpio_function fn)
+{
+    (void)gpio;
+    (void)fn;
+}
+
+static inline void gpio_pull_up(uint gpio)
+{
+    (void)gpio;
+}
+
+#endif
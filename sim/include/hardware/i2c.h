@@ -0,0 +1,17 @@
+/*
+Stand-in for the Pico SDK header of the same name, used by the host-side simulator
+There is no bus in the simulator, the accelerometer is an adxl343_mock (see sim/sim_hw.h). These only let the driver
+build, and fail every transfer.
+*/
+#ifndef SIM_HARDWARE_I2C_H
+#define SIM_HARDWARE_I2C_H
+
+#include "pico/stdlib.h"
+
+typedef struct i2c_inst i2c_inst_t;
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us);
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+Stand-in for the Pico SDK header of the same name, used by the host-side simulator
+
+Only the TX side of the ws2812 state machine is modelled: words pushed with pio_sm_put_blocking (or by DMA) wait in an
+8 entry (joined) FIFO and are then shifted onto the wire at 800kHz. The simulator watches the wire for the reset gap
+that latches a frame into the LEDs.
+*/
+#ifndef SIM_HARDWARE_PIO_H
+#define SIM_HARDWARE_PIO_H
+
+#include "pico/stdlib.h"
+
+typedef struct pio_hw {
+    volatile uint32_t txf[4];
+} pio_hw_t;
+typedef pio_hw_t *PIO;
+
+typedef struct pio_program {
+    const uint16_t *instructions;
+    uint8_t length;
+    int8_t origin;
+} pio_program_t;
+
+extern pio_hw_t *const sim_pio0;
+#define pio0 sim_pio0
+
+static inline uint pio_add_program(PIO pio, const pio_program_t *program)
+{
+    (void)pio;
+    (void)program;
+    return 0;
+}
+
+static inline uint pio_get_dreq(PIO pio, uint sm, bool is_tx)
+{
+    (void)pio;
+    (void)is_tx;
+    return sm;
+}
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data);
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm);
+
+#endif
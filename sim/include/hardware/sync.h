@@ -0,0 +1,26 @@
+/*
+Stand-in for the Pico SDK header of the same name, used by the host-side simulator
+*/
+#ifndef SIM_HARDWARE_SYNC_H
+#define SIM_HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+#define __dmb()     __atomic_thread_fence(__ATOMIC_SEQ_CST)
+
+// waiting for an event advances the virtual clock, and there is nobody to wake up
+#define __wfe()     tight_loop_contents()
+#define __sev()     ((void)0)
+
+// interrupts are only ever taken where the simulated core waits, so there is nothing to disable
+static inline uint32_t save_and_disable_interrupts(void)
+{
+    return 0;
+}
+
+static inline void restore_interrupts(uint32_t status)
+{
+    (void)status;
+}
+
+#endif
@@ -0,0 +1,15 @@
+/*
+Stand-in for the Pico SDK header of the same name, used by the host-side simulator
+The inter-core FIFO is modelled as an 8 entry queue between the simulated cores
+*/
+#ifndef SIM_PICO_MULTICORE_H
+#define SIM_PICO_MULTICORE_H
+
+#include "pico/stdlib.h"
+
+bool multicore_fifo_rvalid(void);
+bool multicore_fifo_wready(void);
+void multicore_fifo_push_blocking(uint32_t data);
+uint32_t multicore_fifo_pop_blocking(void);
+
+#endif
@@ -0,0 +1,14 @@
+/*
+Stand-in for the Pico SDK header of the same name, used by the host-side simulator
+*/
+#ifndef SIM_PICO_RAND_H
+#define SIM_PICO_RAND_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+static inline uint32_t get_rand_32(void) {
+    return ((uint32_t)rand() << 16) ^ (uint32_t)rand();
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+Stand-in for the Pico SDK header of the same name, used by the host-side simulator
+
+Time is virtual: time_us_64() returns the clock of whichever core the simulator is currently running, and every call
+that waits (sleep_us, tight_loop_contents, blocking FIFO and PIO calls) advances that clock instead of the wall clock.
+*/
+#ifndef SIM_PICO_STDLIB_H
+#define SIM_PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+
+enum pico_error_codes {
+    PICO_OK = 0,
+    PICO_ERROR_NONE = 0,
+    PICO_ERROR_TIMEOUT = -1,
+    PICO_ERROR_GENERIC = -2,
+    PICO_ERROR_NO_DATA = -3,
+};
+
+typedef uint64_t absolute_time_t;
+
+static inline absolute_time_t from_us_since_boot(uint64_t us)
+{
+    return us;
+}
+
+static inline uint64_t to_us_since_boot(absolute_time_t t)
+{
+    return t;
+}
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void)
+{
+    return (uint32_t)time_us_64();
+}
+// the core the simulator is currently running
+uint get_core_num(void);
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void tight_loop_contents(void);
+
+// the SDK's stdlib brings the gpio functions along too
+#include "hardware/gpio.h"
+
+#endif
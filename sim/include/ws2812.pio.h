@@ -0,0 +1,33 @@
+/*
+Stand-in for the header pico_generate_pio_header builds from lib/ws2812.pio, used by the host-side simulator
+*/
+#ifndef SIM_WS2812_PIO_H
+#define SIM_WS2812_PIO_H
+
+#include "hardware/pio.h"
+
+static const pio_program_t ws2812_program;
+
+static inline void ws2812_program_init(PIO pio, uint sm, uint offset, uint pin, float freq, bool rgbw)
+{
+    (void)pio;
+    (void)sm;
+    (void)offset;
+    (void)pin;
+    (void)freq;
+    (void)rgbw;
+}
+
+static const pio_program_t ws2812_parallel_program;
+
+static inline void ws2812_parallel_program_init(PIO pio, uint sm, uint offset, uint pin_base, uint pin_count, float freq)
+{
+    (void)pio;
+    (void)sm;
+    (void)offset;
+    (void)pin_base;
+    (void)pin_count;
+    (void)freq;
+}
+
+#endif
@@ -0,0 +1,635 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <setjmp.h>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/timer.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+
+#include "ADXL343.h"
+#include "neopixels.h"
+#include "sim_hw.h"
+
+
+adxl343_mock sim_accelerometer;
+
+// the run currently being simulated
+static const sim_capture *cap;
+static sim_trace *trace;
+static sim_core0_step_fn core0_step_fn;
+static jmp_buf capture_done;
+
+// virtual clocks. Core 0 runs at the timestamps of the capture, core 1 advances whenever it waits
+static int on_core;
+static size_t next_sample;
+static uint64_t core0_now, core1_now;
+
+// inter-core FIFO, core 0 -> core 1
+#define SIM_FIFO_DEPTH  8
+static uint32_t fifo[SIM_FIFO_DEPTH];
+static int fifo_head, fifo_count;
+static bool swing_pending;
+static uint32_t swing_pending_val;
+static uint64_t swing_pending_t;
+
+// ws2812 state machine. word_start holds the times the last SIM_WS2812_FIFO_DEPTH words were pulled out of the FIFO
+static uint64_t word_start[SIM_WS2812_FIFO_DEPTH];
+static size_t n_words;
+static uint64_t wire_end;
+static sim_frame frame;
+static uint32_t frame_words;
+
+// with several strips, every word is one bit of a pixel of each strip (see ws2812_transpose_column)
+#if WS2812_N_STRIPS > 1
+#define SIM_WORDS_PER_PIXEL     WS2812_PIXEL_BITS
+#else
+#define SIM_WORDS_PER_PIXEL     1
+#endif
+
+// the state machine shifts out the top WS2812_PIXEL_BITS of every pixel, see WS2812_PIXEL_FORMAT
+#define SIM_PIXEL_US            (WS2812_PIXEL_BITS * SIM_WS2812_BIT_NS / 1000)
+
+// hardware alarms, and the DMA channel feeding the ws2812 state machine
+#define SIM_N_ALARMS    4
+static hardware_alarm_callback_t alarm_callback[SIM_N_ALARMS];
+static bool alarm_armed[SIM_N_ALARMS];
+static uint64_t alarm_target[SIM_N_ALARMS];
+static int n_alarms_claimed;
+static int n_dma_claimed;
+static uint64_t dma_busy_until;
+
+
+static void *grow(void *array, size_t count, size_t elem_size)
+{
+    // grow by doubling whenever count reaches a power of two
+    if (count == 0 || (count & (count - 1)) == 0) {
+        array = realloc(array, (count == 0 ? 1 : count * 2) * elem_size);
+        if (array == NULL) {
+            fprintf(stderr, "sim: out of memory\n");
+            exit(1);
+        }
+    }
+    return array;
+}
+
+
+// runs core 0 on every sample read up to time t. Ends the simulation when the capture runs out
+static void catch_up_core0(uint64_t t)
+{
+    while (next_sample < cap->n && cap->t_us[next_sample] <= t) {
+        on_core = 0;
+        core0_now = cap->t_us[next_sample];
+        // the sample is measured just as core 0 gets to it
+        adxl343_mock_push(&sim_accelerometer, &(adxl343_xyz){cap->ax_raw[next_sample], 0, 0});
+        core0_step_fn();
+        next_sample++;
+        on_core = 1;
+    }
+
+    if (next_sample >= cap->n)
+        longjmp(capture_done, 1);
+}
+
+
+// returns the armed alarm that fires first at or before time t, or -1 if there is none
+static int next_alarm(uint64_t t)
+{
+    int i, first = -1;
+
+    for (i = 0; i < SIM_N_ALARMS; i++) {
+        if (alarm_armed[i] && alarm_target[i] <= t && (first < 0 || alarm_target[i] < alarm_target[first]))
+            first = i;
+    }
+    return first;
+}
+
+
+static void advance_core1(uint64_t us)
+{
+    uint64_t end;
+    int alarm;
+
+    if (us > UINT64_MAX - core1_now)
+        us = UINT64_MAX - core1_now;
+    end = core1_now + us;
+
+    // alarms interrupt core 1 at their target time, with core 0 caught up to that point
+    while ((alarm = next_alarm(end)) >= 0) {
+        if (alarm_target[alarm] > core1_now)
+            core1_now = alarm_target[alarm];
+        catch_up_core0(core1_now);
+        alarm_armed[alarm] = false;
+        alarm_callback[alarm]((uint)alarm);
+    }
+
+    core1_now = end;
+    catch_up_core0(core1_now);
+}
+
+
+static void latch_frame(void)
+{
+    if (frame.n_pixels == 0)
+        return;
+
+    frame.t_us = wire_end + SIM_WS2812_RESET_US;
+    if (trace->n_swings > 0) {
+        sim_swing *swing = &trace->swings[frame.swing];
+        if (swing->n_frames == 0)
+            swing->first_frame = trace->n_frames;
+        swing->n_frames++;
+    }
+
+    trace->frames = grow(trace->frames, trace->n_frames, sizeof(sim_frame));
+    trace->frames[trace->n_frames++] = frame;
+    frame.n_pixels = 0;
+    frame.lit = 0;
+    frame_words = 0;
+}
+
+
+uint64_t time_us_64(void)
+{
+    return on_core == 0 ? core0_now : core1_now;
+}
+
+
+uint get_core_num(void)
+{
+    return (uint)on_core;
+}
+
+
+void sleep_us(uint64_t us)
+{
+    if (on_core == 0) {
+        core0_now += us;
+        return;
+    }
+
+    if (us > SIM_STALL_US)
+        trace->stalls++;
+    advance_core1(us);
+}
+
+
+void sleep_ms(uint32_t ms)
+{
+    sleep_us((uint64_t)ms * 1000);
+}
+
+
+void tight_loop_contents(void)
+{
+    // nothing can change until core 0 reads its next sample, so skip straight to it
+    if (on_core == 1 && next_sample < cap->n && cap->t_us[next_sample] > core1_now)
+        advance_core1(cap->t_us[next_sample] - core1_now);
+    else if (on_core == 1)
+        advance_core1(1);
+}
+
+
+bool multicore_fifo_rvalid(void)
+{
+    return fifo_count > 0;
+}
+
+
+bool multicore_fifo_wready(void)
+{
+    return fifo_count < SIM_FIFO_DEPTH;
+}
+
+
+void multicore_fifo_push_blocking(uint32_t data)
+{
+    // outside of sim_run (the benchmarks link these stand-ins too) there is no core 1 to signal
+    if (trace == NULL)
+        return;
+
+    // core 1 only runs between core 0 samples here, so a full FIFO can't drain. Count it and drop the value
+    if (fifo_count == SIM_FIFO_DEPTH) {
+        trace->fifo_overflows++;
+        return;
+    }
+
+    fifo[(fifo_head + fifo_count) % SIM_FIFO_DEPTH] = data;
+    fifo_count++;
+
+    trace->signals = grow(trace->signals, trace->n_signals, sizeof(sim_signal));
+    trace->signals[trace->n_signals].t_us = time_us_64();
+    trace->signals[trace->n_signals].fifo_val = data;
+    trace->n_signals++;
+}
+
+
+uint32_t multicore_fifo_pop_blocking(void)
+{
+    uint32_t data;
+
+    while (fifo_count == 0)
+        tight_loop_contents();
+
+    data = fifo[fifo_head];
+    fifo_head = (fifo_head + 1) % SIM_FIFO_DEPTH;
+    fifo_count--;
+
+    // the next frame sent to the strip starts a new swing
+    swing_pending = true;
+    swing_pending_val = data;
+    swing_pending_t = core1_now;
+
+    return data;
+}
+
+
+static pio_hw_t pio0_hw;
+pio_hw_t *const sim_pio0 = &pio0_hw;
+
+
+// the time a word put into the TX FIFO now would find room there
+static uint64_t fifo_space_time(void)
+{
+    if (n_words < SIM_WS2812_FIFO_DEPTH)
+        return 0;
+    return word_start[n_words % SIM_WS2812_FIFO_DEPTH];
+}
+
+
+// puts a word into the TX FIFO at time t, which must have room for it by then
+static void wire_push(uint64_t t, uint32_t data)
+{
+    uint64_t start = t > wire_end ? t : wire_end;
+
+    // a long enough low period on the wire latches whatever was sent before it
+    if (frame.n_pixels > 0 && start >= wire_end + SIM_WS2812_RESET_US)
+        latch_frame();
+
+    if (frame.n_pixels == 0) {
+        if (swing_pending) {
+            trace->swings = grow(trace->swings, trace->n_swings, sizeof(sim_swing));
+            trace->swings[trace->n_swings].t_us = swing_pending_t;
+            trace->swings[trace->n_swings].fifo_val = swing_pending_val;
+            trace->swings[trace->n_swings].first_frame = 0;
+            trace->swings[trace->n_swings].n_frames = 0;
+            trace->n_swings++;
+            swing_pending = false;
+        }
+        frame.swing = trace->n_swings > 0 ? trace->n_swings - 1 : 0;
+    }
+
+#if WS2812_N_STRIPS > 1
+    {
+        // bit s of the word is a bit of pixel p of strip s, which is pixel s * WS2812_N_PIXELS + p of the column
+        uint32_t p = frame_words / SIM_WORDS_PER_PIXEL, k = frame_words % SIM_WORDS_PER_PIXEL;
+        int s;
+
+        for (s = 0; s < WS2812_N_STRIPS; s++) {
+            if ((data >> s) & 1 && s * WS2812_N_PIXELS + p < SIM_MAX_FRAME_PIXELS)
+                frame.lit |= 1u << (s * WS2812_N_PIXELS + p);
+        }
+        frame.n_pixels = (p + 1) * WS2812_N_STRIPS;
+
+        // spread the pixel's time on the wire evenly over its words
+        word_start[n_words % SIM_WS2812_FIFO_DEPTH] = start;
+        n_words++;
+        wire_end = start + SIM_PIXEL_US * (k + 1) / SIM_WORDS_PER_PIXEL - SIM_PIXEL_US * k / SIM_WORDS_PER_PIXEL;
+    }
+#else
+    if (data >> (32 - WS2812_PIXEL_BITS) != 0 && frame.n_pixels < SIM_MAX_FRAME_PIXELS)
+        frame.lit |= 1u << frame.n_pixels;
+    frame.n_pixels++;
+
+    word_start[n_words % SIM_WS2812_FIFO_DEPTH] = start;
+    n_words++;
+    wire_end = start + SIM_PIXEL_US;
+#endif
+    frame_words++;
+}
+
+
+void pio_sm_put_blocking(PIO pio, uint sm, uint32_t data)
+{
+    uint64_t room;
+    (void)pio;
+    (void)sm;
+
+    // block until the oldest word in the TX FIFO has been pulled into the output shift register
+    room = fifo_space_time();
+    if (room > core1_now)
+        advance_core1(room - core1_now);
+
+    wire_push(core1_now, data);
+}
+
+
+bool pio_sm_is_tx_fifo_empty(PIO pio, uint sm)
+{
+    (void)pio;
+    (void)sm;
+
+    if (n_words == 0)
+        return true;
+    return word_start[(n_words - 1) % SIM_WS2812_FIFO_DEPTH] <= core1_now;
+}
+
+
+int dma_claim_unused_channel(bool required)
+{
+    (void)required;
+    return n_dma_claimed++;
+}
+
+
+dma_channel_config dma_channel_get_default_config(uint channel)
+{
+    dma_channel_config c = {0};
+    (void)channel;
+    return c;
+}
+
+
+void channel_config_set_transfer_data_size(dma_channel_config *c, enum dma_channel_transfer_size size)
+{
+    (void)c;
+    (void)size;
+}
+
+
+void channel_config_set_read_increment(dma_channel_config *c, bool incr)
+{
+    (void)c;
+    (void)incr;
+}
+
+
+void channel_config_set_write_increment(dma_channel_config *c, bool incr)
+{
+    (void)c;
+    (void)incr;
+}
+
+
+void channel_config_set_dreq(dma_channel_config *c, uint dreq)
+{
+    (void)c;
+    (void)dreq;
+}
+
+
+void dma_channel_configure(uint channel, const dma_channel_config *config, volatile void *write_addr,
+                           const volatile void *read_addr, uint transfer_count, bool trigger)
+{
+    (void)channel;
+    (void)config;
+    (void)write_addr;
+    (void)read_addr;
+    (void)transfer_count;
+    (void)trigger;
+}
+
+
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void *read_addr, uint32_t transfer_count)
+{
+    const volatile uint32_t *words = read_addr;
+    uint64_t t = time_us_64();
+    uint32_t i;
+    (void)channel;
+
+    // the DREQ paces every word into the FIFO as soon as there is room, without holding up the CPU
+    for (i = 0; i < transfer_count; i++) {
+        uint64_t room = fifo_space_time();
+        if (room > t)
+            t = room;
+        wire_push(t, words[i]);
+    }
+    dma_busy_until = t;
+}
+
+
+bool dma_channel_is_busy(uint channel)
+{
+    (void)channel;
+    return dma_busy_until > time_us_64();
+}
+
+
+int hardware_alarm_claim_unused(bool required)
+{
+    if (n_alarms_claimed >= SIM_N_ALARMS) {
+        if (required) {
+            fprintf(stderr, "sim: no free hardware alarms\n");
+            exit(1);
+        }
+        return -1;
+    }
+    return n_alarms_claimed++;
+}
+
+
+void hardware_alarm_set_callback(uint alarm_num, hardware_alarm_callback_t callback)
+{
+    alarm_callback[alarm_num] = callback;
+    alarm_armed[alarm_num] = false;
+}
+
+
+bool hardware_alarm_set_target(uint alarm_num, absolute_time_t t)
+{
+    // like the SDK, report a target that has already passed instead of arming the alarm
+    if (to_us_since_boot(t) <= time_us_64())
+        return true;
+
+    alarm_target[alarm_num] = to_us_since_boot(t);
+    alarm_armed[alarm_num] = true;
+    return false;
+}
+
+
+void hardware_alarm_cancel(uint alarm_num)
+{
+    alarm_armed[alarm_num] = false;
+}
+
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate)
+{
+    (void)i2c;
+    return baudrate;
+}
+
+
+int i2c_write_timeout_us(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop, uint timeout_us)
+{
+    (void)i2c;
+    (void)addr;
+    (void)src;
+    (void)len;
+    (void)nostop;
+    (void)timeout_us;
+    return PICO_ERROR_GENERIC;
+}
+
+
+int i2c_read_timeout_us(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop, uint timeout_us)
+{
+    (void)i2c;
+    (void)addr;
+    (void)dst;
+    (void)len;
+    (void)nostop;
+    (void)timeout_us;
+    return PICO_ERROR_GENERIC;
+}
+
+
+uint spi_init(spi_inst_t *spi, uint baudrate)
+{
+    (void)spi;
+    return baudrate;
+}
+
+
+void spi_set_format(spi_inst_t *spi, uint data_bits, spi_cpol_t cpol, spi_cpha_t cpha, spi_order_t order)
+{
+    (void)spi;
+    (void)data_bits;
+    (void)cpol;
+    (void)cpha;
+    (void)order;
+}
+
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len)
+{
+    (void)spi;
+    (void)src;
+    return (int)len;
+}
+
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len)
+{
+    (void)spi;
+    (void)repeated_tx_data;
+    memset(dst, 0, len);
+    return (int)len;
+}
+
+
+int sim_capture_load(const char *path, sim_capture *capture)
+{
+    FILE *f;
+    long size;
+    char *buf, *p, *end;
+
+    memset(capture, 0, sizeof(*capture));
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+        return -1;
+    fseek(f, 0, SEEK_END);
+    size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    buf = malloc(size + 1);
+    if (buf == NULL || fread(buf, 1, size, f) != (size_t)size) {
+        fclose(f);
+        free(buf);
+        return -1;
+    }
+    buf[size] = '\0';
+    fclose(f);
+
+    // skip the header. The original logger wrote it without a line ending, so it may run into the first record
+    p = buf;
+    if (!isdigit((unsigned char)*p) && *p != '-' && *p != '.') {
+        char *hdr_end = strstr(p, "(us)");
+        if (hdr_end != NULL)
+            p = hdr_end + strlen("(us)");
+        else
+            p += strcspn(p, "\r\n");
+    }
+
+    while (*p != '\0') {
+        double accel_mss;
+        unsigned long long t;
+
+        while (*p == '\r' || *p == '\n' || *p == ' ' || *p == '\t')
+            p++;
+        if (*p == '\0')
+            break;
+
+        accel_mss = strtod(p, &end);
+        if (end == p || *end != ',')
+            break;
+        p = end + 1;
+        t = strtoull(p, &end, 10);
+        if (end == p)
+            break;
+        p = end;
+
+        capture->t_us = grow(capture->t_us, capture->n, sizeof(uint64_t));
+        capture->ax_raw = grow(capture->ax_raw, capture->n, sizeof(int16_t));
+        capture->t_us[capture->n] = t;
+        capture->ax_raw[capture->n] = (int16_t)lround(accel_mss / (ADXL3XXVAL_TO_MSS));
+        capture->n++;
+    }
+
+    free(buf);
+    return capture->n > 0 ? 0 : -1;
+}
+
+
+void sim_capture_free(sim_capture *capture)
+{
+    free(capture->t_us);
+    free(capture->ax_raw);
+    memset(capture, 0, sizeof(*capture));
+}
+
+
+void sim_run(const sim_capture *capture, sim_core0_step_fn core0_step, sim_core1_main_fn core1_main, sim_trace *out_trace)
+{
+    cap = capture;
+    trace = out_trace;
+    core0_step_fn = core0_step;
+    memset(trace, 0, sizeof(*trace));
+
+    on_core = 1;
+    next_sample = 0;
+    core0_now = 0;
+    core1_now = capture->t_us[0];
+    fifo_head = 0;
+    fifo_count = 0;
+    swing_pending = false;
+    n_words = 0;
+    wire_end = 0;
+    memset(&frame, 0, sizeof(frame));
+    frame_words = 0;
+    memset(alarm_armed, 0, sizeof(alarm_armed));
+    n_alarms_claimed = 0;
+    n_dma_claimed = 0;
+    dma_busy_until = 0;
+
+    if (setjmp(capture_done) == 0)
+        core1_main();
+
+    // let the last frame latch
+    latch_frame();
+}
+
+
+void sim_trace_free(sim_trace *t)
+{
+    free(t->signals);
+    free(t->swings);
+    free(t->frames);
+    memset(t, 0, sizeof(*t));
+}
@@ -0,0 +1,89 @@
+/*
+Virtual hardware for the host-side light wand simulator
+
+A capture (accelerometer samples with their timestamps) is replayed into core 0, while core 1 runs the real display
+code against the stand-in SDK headers in sim/include. Core 1 drives the simulation: every time it waits on the
+virtual clock, core 0 is caught up on all samples read up to that time. Everything observable about the run (FIFO
+signals, swings started by core 1, frames latched by the LED strip) is recorded into a sim_trace.
+*/
+#ifndef SIM_HW_H
+#define SIM_HW_H
+
+#include "pico/stdlib.h"
+#include "ADXL343.h"
+
+// ws2812 wire timing: one bit every 1.25us at 800kHz, and the low time that latches a frame into the LEDs
+#define SIM_WS2812_BIT_NS       1250
+#define SIM_WS2812_RESET_US     50
+#define SIM_WS2812_FIFO_DEPTH   8
+#define SIM_MAX_FRAME_PIXELS    32
+
+// sleeps longer than this are reported as core 1 stalls (usually an underflowed column time)
+#define SIM_STALL_US            (1000 * 1000)
+
+// A recorded capture, with the accelerometer x axis converted back into raw ADXL343 counts
+typedef struct sim_capture_struct {
+    size_t n;
+    uint64_t *t_us;
+    int16_t *ax_raw;
+} sim_capture;
+
+// A value core 0 pushed onto the inter-core FIFO
+typedef struct sim_signal_struct {
+    uint64_t t_us;
+    uint32_t fifo_val;
+} sim_signal;
+
+// A swing started by core 1, with the FIFO value it was started from
+typedef struct sim_swing_struct {
+    uint64_t t_us;
+    uint32_t fifo_val;
+    size_t first_frame;
+    size_t n_frames;
+} sim_swing;
+
+// A frame latched by the LED strip. Bit i of lit is set if pixel i was sent a non-zero colour
+typedef struct sim_frame_struct {
+    uint64_t t_us;
+    size_t swing;
+    uint32_t n_pixels;
+    uint32_t lit;
+} sim_frame;
+
+typedef struct sim_trace_struct {
+    sim_signal *signals;
+    size_t n_signals;
+    sim_swing *swings;
+    size_t n_swings;
+    sim_frame *frames;
+    size_t n_frames;
+    size_t fifo_overflows;  // pushes core 0 would have blocked on
+    size_t stalls;          // core 1 sleeps longer than SIM_STALL_US
+} sim_trace;
+
+// The accelerometer of the simulation. Each sample of the capture is pushed into it just before core 0 is run on it,
+// so core 0 reads it through the real driver (see adxl343_setup_mock)
+extern adxl343_mock sim_accelerometer;
+
+// run once per capture sample, on the simulated core 0
+typedef void (*sim_core0_step_fn)(void);
+// core 1 entry point. Never needs to return, the simulation ends when the capture runs out
+typedef void (*sim_core1_main_fn)(void);
+
+/*
+Loads a capture written by the accelerometer_data target (acceleration in m/s/s, time since boot in us)
+Records may be separated by '\r' or '\n', and the header line is optional
+Returns 0 on success, -1 on failure
+*/
+int sim_capture_load(const char *path, sim_capture *capture);
+
+void sim_capture_free(sim_capture *capture);
+
+/*
+Replays the capture through core0_step and core1_main, recording the result into trace
+*/
+void sim_run(const sim_capture *capture, sim_core0_step_fn core0_step, sim_core1_main_fn core1_main, sim_trace *trace);
+
+void sim_trace_free(sim_trace *trace);
+
+#endif
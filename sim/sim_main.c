@@ -0,0 +1,814 @@
+/*
+Main C file for the host-side light wand simulator
+
+Replays recorded accelerometer captures through the direction detector and column display code in src/pov.c on a
+virtual clock, then scores how well the columns would have landed:
+
+    start error how far from the true reversal of the wand the new swing was started, either way
+    dropped     columns of each swing that were never shown because the next swing started first
+    decimated   columns left out of swings that were too short for all of them, counted at half weight as the
+                swing still shows the whole image
+    drift       how far the same column lands from where it landed on the previous swing in that direction
+
+Every sample is also run through a copy of the original floating point detector, and any sample on which the two
+disagree is counted in detector_mismatches, which should always be 0. The time from the true reversal to core 0
+signalling the swing is reported as latency, which is negative for swings started ahead of the reversal.
+
+The period error of the swing predictor (how far each predicted swing length was from the one that followed) is
+reported alongside, but is not part of the score. -p selects the predictor, see inc/predictor.h, and -r sets the
+run length of the direction detector's hysteresis.
+
+The true reversals are taken from the capture itself: the motion of the wand is close to harmonic, so the position
+is roughly proportional to minus the acceleration, and the wand turns around at the extremes of the (smoothed)
+acceleration. Between reversals the position is the capture's acceleration integrated twice, with the wand at rest
+at both ends, which is also what the long exposure image is drawn from.
+
+-m shows other text than the default, which scrolls past as a marquee if it is too long for the display.
+
+-t prints the events traced on both cores (see inc/trace.h) in the format of the TRACE command, which
+scripts/trace_histogram.py reads, and the trace counters are printed at the end of every capture.
+
+Usage: light-wand-sim [-v] [-t] [-i image_dir] [-p last|ewma|pll] [-r run_length] [-m message] capture.csv [capture.csv ...]
+Prints one key=value per line per capture, followed by the mean score of the corpus. Lower scores are better.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+
+#include "ADXL343.h"
+#include "pov.h"
+#include "sampler.h"
+#include "trace.h"
+#include "sim_hw.h"
+
+
+// half width of the centered moving average applied before looking for reversals
+#define SIM_SMOOTH_US           20000
+// how far (in raw counts) the smoothed acceleration must come back from an extreme to count it as a reversal
+#define SIM_REVERSAL_DELTA      40
+// a half swing longer than this is the wand resting, not swinging
+#define SIM_MAX_HALF_SWING_US   1500000
+// width of the long exposure image in pixels
+#define SIM_IMAGE_WIDTH         400
+
+// a turnaround of the wand found in the capture. dir is the display direction the detector should switch to
+typedef struct sim_reversal_struct {
+    uint64_t t_us;
+    size_t i;           // sample of the capture it was found at
+    int dir;
+} sim_reversal;
+
+// where the wand was at every sample of a capture, from -1 (far left) to 1 (far right), NAN while it wasn't swinging
+typedef struct sim_motion_struct {
+    const uint64_t *t_us;
+    double *x;
+    size_t n;
+} sim_motion;
+
+typedef struct sim_metrics_struct {
+    size_t n_reversals;
+    size_t n_detected;
+    size_t n_spurious;
+    double latency_ms_mean;
+    double latency_ms_max;
+    double start_error_ms_mean;
+    size_t n_swings;
+    double dropped_mean;
+    double decimated_mean;
+    double drift_px_mean;
+    double placement_px_mean;
+    double period_error_ms_mean;
+    size_t detector_mismatches;
+    double score;
+} sim_metrics;
+
+
+static adxl343 accelerometer;
+static pov_detector detector;
+static predictor_kind predictor_choice = POV_PREDICTOR;
+static uint run_length = DIR_RUN_LENGTH;
+static pov_renderer renderer;
+
+// the direction detector as it was first written, with float jerk and 64 bit direction histories
+typedef struct legacy_detector_struct {
+    float prev_accel_mss;
+    uint64_t prev_frame_time;
+    uint64_t hidden_dir_hist;
+    uint64_t display_dir_hist;
+    uint64_t mask;
+} legacy_detector;
+
+static legacy_detector legacy;
+static size_t detector_mismatches;
+static size_t batch_n;
+static int verbose;
+static int dump_trace;
+
+// display direction of every swing signalled so far, indexed by seq. The FIFO only carries seq as a doorbell
+static uint8_t *swing_dirs;
+static size_t n_swing_dirs;
+// and the time each swing was started from, and the columns core 1 gave it
+static uint64_t *swing_starts;
+static uint16_t *swing_columns;
+static uint32_t recorded_seq;
+
+// the swing length predicted at the last reversal, and how far the predictions have been off
+static uint64_t predicted_us;
+static double period_error_sum_ms;
+static size_t n_period_errors;
+
+
+static void legacy_init(legacy_detector *d, uint run)
+{
+    memset(d, 0, sizeof(*d));
+    d->mask = run >= 64 ? ~(uint64_t)0 : ((uint64_t)1 << run) - 1;
+}
+
+
+// returns true if the displayed direction changed
+static bool legacy_update_direction(legacy_detector *d, uint64_t now, int16_t ax_raw)
+{
+    uint64_t i;
+    bool changed = false;
+    float accel_mss = (float)ax_raw * ADXL3XXVAL_TO_MSS;
+    float jerk_msss = (accel_mss - d->prev_accel_mss) / ((float)(now - d->prev_frame_time) / 1000000.0f);
+
+    if (jerk_msss < 0)
+        d->hidden_dir_hist = (d->hidden_dir_hist << 1) | 0;
+    else if (jerk_msss > 0)
+        d->hidden_dir_hist = (d->hidden_dir_hist << 1) | 1;
+    else {
+        i = d->hidden_dir_hist & 1;
+        d->hidden_dir_hist = (d->hidden_dir_hist << 1) | i;
+    }
+
+    if (((d->hidden_dir_hist & d->mask) == 0) && ((d->display_dir_hist & 1) == 1)) {
+        d->display_dir_hist = (d->display_dir_hist << 1) | 0;
+        changed = true;
+    }
+    else if (((d->hidden_dir_hist & d->mask) == d->mask) && ((d->display_dir_hist & 1) == 0)) {
+        d->display_dir_hist = (d->display_dir_hist << 1) | 1;
+        changed = true;
+    }
+    else {
+        i = d->display_dir_hist & 1;
+        d->display_dir_hist = (d->display_dir_hist << 1) | i;
+    }
+
+    d->prev_accel_mss = accel_mss;
+    d->prev_frame_time = now;
+    return changed;
+}
+
+
+// records the swing the detector signalled last, if it has not been recorded yet
+static void record_swing(uint8_t dir, uint64_t start_us)
+{
+    if (detector.seq == recorded_seq)
+        return;
+    recorded_seq = detector.seq;
+
+    if (detector.seq >= n_swing_dirs) {
+        n_swing_dirs = n_swing_dirs == 0 ? 64 : n_swing_dirs * 2;
+        swing_dirs = realloc(swing_dirs, n_swing_dirs);
+        swing_starts = realloc(swing_starts, n_swing_dirs * sizeof(uint64_t));
+        swing_columns = realloc(swing_columns, n_swing_dirs * sizeof(uint16_t));
+        if (swing_dirs == NULL || swing_starts == NULL || swing_columns == NULL) {
+            fprintf(stderr, "sim: out of memory\n");
+            exit(1);
+        }
+    }
+    swing_dirs[detector.seq] = dir;
+    swing_starts[detector.seq] = start_us;
+    swing_columns[detector.seq] = N_DISPLAY_COLUMNS;
+}
+
+
+/*
+Mirrors the POV branch of the core 0 loop in main(). Samples collect in the accelerometer's FIFO until the
+watermark is reached, then the sampler reads the whole batch into its ring, and it is run through the detector
+with the times the sampler gave the samples.
+*/
+static void core0_step(void)
+{
+    sampler_entry sample;
+
+    if (++batch_n < ADX_FIFO_WATERMARK)
+        return;
+
+    // the WATERMARK interrupt, or the sampler's poll a batch after the last. The mock's batch is read straight away
+    sampler_watermark();
+
+    while (sampler_pop(&sample)) {
+        uint64_t next_reversal;
+        bool changed = pov_update_direction(&detector, sample.t_us, sample.xyz.x);
+
+        if (legacy_update_direction(&legacy, sample.t_us, sample.xyz.x) != changed ||
+            (legacy.display_dir_hist & 1) != detector.display_dir)
+            detector_mismatches++;
+
+        if (!changed)
+            continue;
+
+        // only judge predictions for swings that were part of the same bout of swinging
+        if (predicted_us != 0 && detector.prev_swing_time_length <= PREDICTOR_MAX_PERIOD_US) {
+            period_error_sum_ms += fabs((double)detector.prev_swing_time_length - (double)predicted_us) / 1000.0;
+            n_period_errors++;
+        }
+        next_reversal = predictor_next_reversal(&detector.predictor);
+        predicted_us = next_reversal > detector.prev_dir_change_time ? next_reversal - detector.prev_dir_change_time : 0;
+
+        // a reversal that was anticipated closely enough is not signalled again
+        record_swing(detector.display_dir, detector.prev_dir_change_time);
+    }
+
+    pov_fit_profile(&detector);
+    if (pov_anticipate_reversal(&detector, time_us_64()))
+        record_swing(!detector.display_dir, detector.anticipated_us);
+    batch_n = 0;
+}
+
+
+// the direction of the swing a doorbell was rung for
+static int doorbell_dir(uint32_t fifo_val)
+{
+    return fifo_val < n_swing_dirs ? swing_dirs[fifo_val] : -1;
+}
+
+
+// the columns core 1 gave the swing a doorbell was rung for
+static uint doorbell_columns(uint32_t fifo_val)
+{
+    return fifo_val < n_swing_dirs ? swing_columns[fifo_val] : N_DISPLAY_COLUMNS;
+}
+
+
+// mirrors core1_main()
+static void core1_main(void)
+{
+    pov_display_init();
+    setup_ws2812_dma();
+
+    while (1) {
+        pov_display_next_swing();
+        if (pov_stats.last_seq < n_swing_dirs)
+            swing_columns[pov_stats.last_seq] = pov_stats.last_columns;
+
+        // a marquee renders the columns it scrolls on by between swings
+        while (pov_renderer_step(&renderer))
+            ;
+
+        // drain the trace once a swing, so the rings never fill up
+        if (dump_trace)
+            trace_dump_events();
+    }
+}
+
+
+/*
+Finds the reversals of the wand from the extremes of the smoothed acceleration
+Returns the number of reversals written to out, which must hold capture->n entries
+*/
+static size_t find_reversals(const sim_capture *capture, sim_reversal *out)
+{
+    size_t i, lo = 0, hi = 0, n = 0, ext = 0;
+    int mode = 0;   // 0: no extreme found yet, 1: looking for a maximum, -1: looking for a minimum
+    double sum = 0, *smooth;
+    size_t min_i = 0, max_i = 0;
+
+    // centered moving average, windowed by time since samples aren't perfectly evenly spaced
+    smooth = malloc(capture->n * sizeof(double));
+    for (i = 0; i < capture->n; i++) {
+        while (hi < capture->n && capture->t_us[hi] <= capture->t_us[i] + SIM_SMOOTH_US)
+            sum += capture->ax_raw[hi++];
+        while (capture->t_us[lo] + SIM_SMOOTH_US < capture->t_us[i])
+            sum -= capture->ax_raw[lo++];
+        smooth[i] = sum / (double)(hi - lo);
+    }
+
+    for (i = 0; i < capture->n; i++) {
+        double v = smooth[i];
+
+        if (mode == 0) {
+            if (v > smooth[max_i]) max_i = i;
+            if (v < smooth[min_i]) min_i = i;
+            if (v - smooth[min_i] > SIM_REVERSAL_DELTA) {
+                ext = min_i;
+                mode = 1;
+            }
+            else if (smooth[max_i] - v > SIM_REVERSAL_DELTA) {
+                ext = max_i;
+                mode = -1;
+            }
+            else {
+                continue;
+            }
+            // the first extreme is confirmed. Fall through to record it
+            i = ext;
+        }
+        else if (mode == 1) {
+            if (v > smooth[ext]) {
+                ext = i;
+                continue;
+            }
+            if (smooth[ext] - v <= SIM_REVERSAL_DELTA)
+                continue;
+            mode = -1;
+        }
+        else {
+            if (v < smooth[ext]) {
+                ext = i;
+                continue;
+            }
+            if (v - smooth[ext] <= SIM_REVERSAL_DELTA)
+                continue;
+            mode = 1;
+        }
+
+        // an acceleration minimum is the far 'right' of the swing, after which the jerk turns positive
+        out[n].t_us = capture->t_us[ext];
+        out[n].i = ext;
+        out[n].dir = mode == 1 ? 1 : 0;
+        n++;
+        ext = i;
+    }
+
+    free(smooth);
+    return n;
+}
+
+
+/*
+Works out where the wand was at every sample of the capture, by integrating its acceleration twice across each half
+swing. The wand is at rest at both reversals, which takes whatever isn't the swing (gravity, offset) out of the
+acceleration, and it goes from one side to the other, which scales the position
+*/
+static void find_motion(const sim_capture *capture, const sim_reversal *revs, size_t n_revs, sim_motion *motion)
+{
+    size_t r, i;
+
+    motion->t_us = capture->t_us;
+    motion->n = capture->n;
+    motion->x = malloc(capture->n * sizeof(double));
+    for (i = 0; i < capture->n; i++)
+        motion->x[i] = NAN;
+
+    for (r = 0; r + 1 < n_revs; r++) {
+        size_t i0 = revs[r].i, i1 = revs[r + 1].i;
+        double t1 = (double)(revs[r + 1].t_us - revs[r].t_us) / 1e6;
+        double v = 0, s = 0, drift, side;
+
+        if (revs[r + 1].t_us - revs[r].t_us > SIM_MAX_HALF_SWING_US || i1 <= i0)
+            continue;
+
+        // the velocity at the end of the half swing is all drift
+        for (i = i0 + 1; i <= i1; i++)
+            v += (capture->ax_raw[i - 1] + capture->ax_raw[i]) / 2.0 * (capture->t_us[i] - capture->t_us[i - 1]) / 1e6;
+        drift = v / t1;
+
+        v = 0;
+        motion->x[i0] = 0;
+        for (i = i0 + 1; i <= i1; i++) {
+            double dt = (capture->t_us[i] - capture->t_us[i - 1]) / 1e6;
+            double v_next = v + ((capture->ax_raw[i - 1] + capture->ax_raw[i]) / 2.0 - drift) * dt;
+            s += (v + v_next) / 2.0 * dt;
+            v = v_next;
+            motion->x[i] = s;
+        }
+
+        // a wand that went nowhere wasn't swinging
+        if (fabs(s) < 1e-9) {
+            for (i = i0; i <= i1; i++)
+                motion->x[i] = NAN;
+            continue;
+        }
+        side = revs[r].dir == 1 ? 1.0 : -1.0;
+        for (i = i0; i <= i1; i++)
+            motion->x[i] = side * (1.0 - 2.0 * motion->x[i] / s);
+    }
+}
+
+
+/*
+Finds the position of the wand at time t, from -1 (far left) to 1 (far right)
+Returns false if the wand isn't swinging at time t
+*/
+static bool position_at(const sim_motion *motion, uint64_t t, double *x)
+{
+    size_t lo = 0, hi = motion->n;
+    double u;
+
+    if (motion->n < 2 || t < motion->t_us[0] || t >= motion->t_us[motion->n - 1])
+        return false;
+
+    // binary search for the samples either side of t
+    while (hi - lo > 1) {
+        size_t mid = (lo + hi) / 2;
+        if (motion->t_us[mid] <= t)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    if (isnan(motion->x[lo]) || isnan(motion->x[lo + 1]))
+        return false;
+
+    u = (double)(t - motion->t_us[lo]) / (double)(motion->t_us[lo + 1] - motion->t_us[lo]);
+    *x = motion->x[lo] + u * (motion->x[lo + 1] - motion->x[lo]);
+    *x = *x < -1.0 ? -1.0 : *x > 1.0 ? 1.0 : *x;
+    return true;
+}
+
+
+static double x_to_px(double x)
+{
+    return (x + 1.0) / 2.0 * (SIM_IMAGE_WIDTH - 1);
+}
+
+
+// the time the swing a doorbell was rung for was started from
+static uint64_t doorbell_start(uint32_t fifo_val)
+{
+    return fifo_val < n_swing_dirs ? swing_starts[fifo_val] : 0;
+}
+
+
+static void measure_latency(const sim_trace *trace, const sim_reversal *revs, size_t n_revs, sim_metrics *m, bool *matched)
+{
+    size_t i, j;
+    double latency_sum = 0, start_error_sum = 0;
+
+    for (i = 0; i < n_revs; i++) {
+        // a signal belongs to the reversal it follows, or anticipates by at most a quarter of a half swing
+        uint64_t after = i + 1 < n_revs ? (revs[i+1].t_us - revs[i].t_us) / 2 : SIM_MAX_HALF_SWING_US / 2;
+        uint64_t before = i > 0 ? (revs[i].t_us - revs[i-1].t_us) / 4 : after / 2;
+        uint64_t start = revs[i].t_us > before ? revs[i].t_us - before : 0;
+
+        for (j = 0; j < trace->n_signals; j++) {
+            const sim_signal *s = &trace->signals[j];
+            double latency_ms, start_error_ms;
+
+            if (matched[j] || s->t_us < start || s->t_us >= revs[i].t_us + after || doorbell_dir(s->fifo_val) != revs[i].dir)
+                continue;
+
+            matched[j] = true;
+            latency_ms = ((double)s->t_us - (double)revs[i].t_us) / 1000.0;
+            start_error_ms = fabs((double)doorbell_start(s->fifo_val) - (double)revs[i].t_us) / 1000.0;
+            latency_sum += latency_ms;
+            start_error_sum += start_error_ms;
+            if (m->n_detected == 0 || latency_ms > m->latency_ms_max)
+                m->latency_ms_max = latency_ms;
+            m->n_detected++;
+
+            if (verbose)
+                printf("reversal t_ms=%.1f dir=%d latency_ms=%.2f start_error_ms=%.2f\n", revs[i].t_us / 1000.0, revs[i].dir,
+                       latency_ms, start_error_ms);
+            break;
+        }
+        if (verbose && j == trace->n_signals)
+            printf("reversal t_ms=%.1f dir=%d missed\n", revs[i].t_us / 1000.0, revs[i].dir);
+    }
+
+    for (j = 0; j < trace->n_signals; j++)
+        if (!matched[j])
+            m->n_spurious++;
+
+    m->n_reversals = n_revs;
+    m->latency_ms_mean = m->n_detected > 0 ? latency_sum / m->n_detected : 0;
+    m->start_error_ms_mean = m->n_detected > 0 ? start_error_sum / m->n_detected : 0;
+}
+
+
+// finds the frame of the swing that showed each framebuffer column, -1 for the columns it did not show
+static void frames_by_column(const sim_swing *swing, int *frames)
+{
+    uint columns = doorbell_columns(swing->fifo_val);
+    uint32_t step;
+    uint first = pov_column_layout(columns, &step);
+    size_t k, i;
+
+    for (k = 0; k < N_DISPLAY_COLUMNS; k++)
+        frames[k] = -1;
+
+    // the display engine shows swings in direction 0 last column first
+    for (k = 0; k < swing->n_frames && k < columns; k++) {
+        i = doorbell_dir(swing->fifo_val) == 0 ? columns - k - 1 : k;
+        frames[first + i * step / WS2812_COL_STEP_ONE] = (int)k;
+    }
+}
+
+
+// how far the columns of a swing landed from where an even layout across the whole swing would put them, in pixels
+// of the long exposure image. Returns -1 if none of them could be placed
+static double swing_placement_px(const sim_swing *swing, const sim_trace *trace, const sim_motion *motion)
+{
+    static double x[N_DISPLAY_COLUMNS], target[N_DISPLAY_COLUMNS];
+    uint columns = doorbell_columns(swing->fifo_val);
+    uint32_t step;
+    uint first = pov_column_layout(columns, &step);
+    double sense = 0, err = 0;
+    size_t k, n = 0;
+
+    // the k'th column out is the k'th from the side the swing started on, whichever direction it went
+    for (k = 0; k < swing->n_frames && k < columns; k++) {
+        if (!position_at(motion, trace->frames[swing->first_frame + k].t_us, &x[n]))
+            continue;
+        target[n] = 1.0 - (2.0 * (first + k * step / WS2812_COL_STEP_ONE) + 1.0) / N_DISPLAY_COLUMNS;
+        sense += x[n] * target[n];
+        n++;
+    }
+    if (n == 0)
+        return -1;
+
+    // which side that was, from whether the columns went across with the targets or against them
+    for (k = 0; k < n; k++)
+        err += fabs(x_to_px(x[k]) - x_to_px(sense >= 0 ? target[k] : -target[k]));
+    return err / n;
+}
+
+
+static void measure_swings(const sim_trace *trace, const sim_motion *motion, sim_metrics *m)
+{
+    size_t s, p, k;
+    static int swing_frames[N_DISPLAY_COLUMNS], prev_frames[N_DISPLAY_COLUMNS];
+    double dropped_sum = 0, decimated_sum = 0, drift_sum = 0, placement_sum = 0, placement;
+    size_t n_drift = 0, n_placement = 0;
+
+    for (s = 0; s < trace->n_swings; s++) {
+        const sim_swing *swing = &trace->swings[s];
+        double swing_drift = 0;
+        size_t n_swing_drift = 0;
+
+        uint columns = doorbell_columns(swing->fifo_val);
+
+        if (swing->n_frames < columns)
+            dropped_sum += columns - (double)swing->n_frames;
+        decimated_sum += N_DISPLAY_COLUMNS - (double)columns;
+
+        // compare against the previous swing in the same direction, framebuffer column by framebuffer column.
+        // Swings given fewer columns only show some of them
+        for (p = s; p-- > 0;)
+            if (doorbell_dir(trace->swings[p].fifo_val) == doorbell_dir(swing->fifo_val))
+                break;
+
+        if (p < s) {
+            const sim_swing *prev = &trace->swings[p];
+            frames_by_column(swing, swing_frames);
+            frames_by_column(prev, prev_frames);
+            for (k = 0; k < N_DISPLAY_COLUMNS; k++) {
+                double x, x_prev;
+                if (swing_frames[k] < 0 || prev_frames[k] < 0 ||
+                    !position_at(motion, trace->frames[swing->first_frame + swing_frames[k]].t_us, &x) ||
+                    !position_at(motion, trace->frames[prev->first_frame + prev_frames[k]].t_us, &x_prev))
+                    continue;
+                swing_drift += fabs(x_to_px(x) - x_to_px(x_prev));
+                n_swing_drift++;
+            }
+        }
+
+        if (n_swing_drift > 0) {
+            drift_sum += swing_drift / n_swing_drift;
+            n_drift++;
+        }
+
+        placement = swing_placement_px(swing, trace, motion);
+        if (placement >= 0) {
+            placement_sum += placement;
+            n_placement++;
+        }
+
+        if (verbose)
+            printf("swing t_ms=%.1f dir=%d columns=%zu/%u drift_px=%.2f\n", swing->t_us / 1000.0, doorbell_dir(swing->fifo_val),
+                   swing->n_frames, columns, n_swing_drift > 0 ? swing_drift / n_swing_drift : 0.0);
+    }
+
+    m->n_swings = trace->n_swings;
+    m->dropped_mean = trace->n_swings > 0 ? dropped_sum / trace->n_swings : 0;
+    m->decimated_mean = trace->n_swings > 0 ? decimated_sum / trace->n_swings : 0;
+    m->drift_px_mean = n_drift > 0 ? drift_sum / n_drift : 0;
+    m->placement_px_mean = n_placement > 0 ? placement_sum / n_placement : 0;
+}
+
+
+// writes the long exposure image as an ascii greymap, brightest where the most columns landed
+static int write_image(const char *path, const sim_trace *trace, const sim_motion *motion)
+{
+    static uint32_t hits[SIM_MAX_FRAME_PIXELS][SIM_IMAGE_WIDTH];
+    uint32_t max_hits = 1;
+    size_t i;
+    int row, col, height = 0;
+    FILE *f;
+
+    memset(hits, 0, sizeof(hits));
+    for (i = 0; i < trace->n_frames; i++) {
+        const sim_frame *fr = &trace->frames[i];
+        double x;
+
+        if (!position_at(motion, fr->t_us, &x))
+            continue;
+        col = (int)lround(x_to_px(x));
+        for (row = 0; row < (int)fr->n_pixels && row < SIM_MAX_FRAME_PIXELS; row++) {
+            if ((fr->lit >> row) & 1) {
+                if (++hits[row][col] > max_hits)
+                    max_hits = hits[row][col];
+            }
+        }
+        if ((int)fr->n_pixels > height)
+            height = fr->n_pixels < SIM_MAX_FRAME_PIXELS ? (int)fr->n_pixels : SIM_MAX_FRAME_PIXELS;
+    }
+
+    f = fopen(path, "w");
+    if (f == NULL)
+        return -1;
+
+    // the lowest pixel on the wand is the bottom row of the image
+    fprintf(f, "P2\n%d %d\n255\n", SIM_IMAGE_WIDTH, height);
+    for (row = height - 1; row >= 0; row--) {
+        for (col = 0; col < SIM_IMAGE_WIDTH; col++)
+            fprintf(f, "%u%c", hits[row][col] * 255 / max_hits, col == SIM_IMAGE_WIDTH - 1 ? '\n' : ' ');
+    }
+
+    fclose(f);
+    return 0;
+}
+
+
+static int simulate(const char *path, const char *image_dir, sim_metrics *m)
+{
+    sim_capture capture;
+    sim_trace trace;
+    sim_reversal *revs;
+    size_t n_revs;
+    sim_motion motion;
+    uint32_t sample_period_us;
+    bool *matched;
+    const char *name;
+    int t;
+
+    if (sim_capture_load(path, &capture) < 0) {
+        fprintf(stderr, "Could not load a capture from %s\n", path);
+        return -1;
+    }
+
+    // core 0 reads the capture through the real driver, with the FIFO streaming as main() sets it up. Not every
+    // capture was sampled at ADX_SAMPLE_PERIOD_US, so the sampler is given the capture's own sample period, as main()
+    // gives it the period of the data rate it sets
+    sample_period_us = capture.n > 1 ? (uint32_t)lround((double)(capture.t_us[capture.n - 1] - capture.t_us[0]) /
+                                                        (double)(capture.n - 1)) : ADX_SAMPLE_PERIOD_US;
+    adxl343_mock_init(&sim_accelerometer);
+    if (adxl343_setup_mock(&accelerometer, &sim_accelerometer) != PICO_ERROR_NONE ||
+        adxl343_set_fifo(&accelerometer, ADXL3XX_FIFO_MODE_STREAM, ADX_FIFO_WATERMARK) < 0 ||
+        sampler_init(&accelerometer, SAMPLER_NO_PIN, ADX_FIFO_WATERMARK, sample_period_us) < 0) {
+        fprintf(stderr, "Could not set up the accelerometer\n");
+        sim_capture_free(&capture);
+        return -1;
+    }
+
+    memset(m, 0, sizeof(*m));
+    pov_detector_init(&detector);
+    predictor_init(&detector.predictor, predictor_choice);
+    pov_detector_set_run_length(&detector, run_length);
+    legacy_init(&legacy, detector.run_length);
+    detector_mismatches = 0;
+    pov_swing_ring_init(&pov_swings);
+    trace_clear();
+    memset((void *)&pov_stats, 0, sizeof(pov_stats));
+    batch_n = 0;
+    recorded_seq = 0;
+    predicted_us = 0;
+    period_error_sum_ms = 0;
+    n_period_errors = 0;
+    sim_run(&capture, core0_step, core1_main, &trace);
+
+    revs = malloc(capture.n * sizeof(sim_reversal));
+    n_revs = find_reversals(&capture, revs);
+    find_motion(&capture, revs, n_revs, &motion);
+    matched = calloc(trace.n_signals + 1, sizeof(bool));
+
+    printf("capture=%s\n", path);
+    measure_latency(&trace, revs, n_revs, m, matched);
+    measure_swings(&trace, &motion, m);
+
+    m->score = m->start_error_ms_mean
+             + (n_revs > 0 ? 100.0 * (double)(n_revs - m->n_detected + m->n_spurious) / n_revs : 0)
+             + 100.0 * m->dropped_mean / N_DISPLAY_COLUMNS
+             + 50.0 * m->decimated_mean / N_DISPLAY_COLUMNS
+             + m->drift_px_mean;
+
+    printf("samples=%zu\n", capture.n);
+    printf("duration_s=%.3f\n", (capture.t_us[capture.n - 1] - capture.t_us[0]) / 1e6);
+    printf("reversals=%zu\n", m->n_reversals);
+    printf("detected=%zu\n", m->n_detected);
+    printf("spurious=%zu\n", m->n_spurious);
+    printf("latency_ms_mean=%.2f\n", m->latency_ms_mean);
+    printf("latency_ms_max=%.2f\n", m->latency_ms_max);
+    printf("start_error_ms_mean=%.2f\n", m->start_error_ms_mean);
+    printf("swings=%zu\n", m->n_swings);
+    printf("columns_dropped_mean=%.1f\n", m->dropped_mean);
+    printf("columns_decimated_mean=%.1f\n", m->decimated_mean);
+    printf("decimated_swings=%u\n", (unsigned)pov_stats.decimated);
+    printf("overruns=%u\n", (unsigned)pov_stats.overruns);
+    printf("drift_px_mean=%.2f\n", m->drift_px_mean);
+    printf("placement_px_mean=%.2f\n", m->placement_px_mean);
+    m->period_error_ms_mean = n_period_errors > 0 ? period_error_sum_ms / n_period_errors : 0;
+    printf("period_error_ms_mean=%.2f\n", m->period_error_ms_mean);
+    m->detector_mismatches = detector_mismatches;
+    printf("detector_mismatches=%zu\n", m->detector_mismatches);
+    printf("fifo_overflows=%zu\n", trace.fifo_overflows);
+    printf("stalls=%zu\n", trace.stalls);
+    for (t = 0; t < TRACE_N_TYPES; t++) {
+        printf("trace_");
+        for (name = trace_type_name(t); *name != '\0'; name++)
+            putchar(tolower((unsigned char)*name));
+        printf("=%u\n", (unsigned)(trace_count(0, t) + trace_count(1, t)));
+    }
+    printf("score=%.2f\n", m->score);
+
+    if (image_dir != NULL) {
+        char image_path[1024];
+        const char *base = strrchr(path, '/');
+        base = base != NULL ? base + 1 : path;
+        snprintf(image_path, sizeof(image_path), "%s/%s.pgm", image_dir, base);
+        if (write_image(image_path, &trace, &motion) < 0)
+            fprintf(stderr, "Could not write %s\n", image_path);
+        else
+            printf("image=%s\n", image_path);
+    }
+
+    free(matched);
+    free(motion.x);
+    free(revs);
+    sim_trace_free(&trace);
+    sim_capture_free(&capture);
+    return 0;
+}
+
+
+int main(int argc, char **argv)
+{
+    const char *image_dir = NULL;
+    double score_sum = 0;
+    int i, n_captures = 0;
+    sim_metrics m;
+
+    // render the default message the same way core1_main() does
+    if (pov_renderer_start(&renderer, POV_DEFAULT_TEXT, MESSAGE_CHAR_SCALE, POV_DEFAULT_SCROLL, PIXEL_CHAR_COLOR,
+                           PIXEL_BG_COLOR) < 0) {
+        fprintf(stderr, "Failed to build the columns\n");
+        return 1;
+    }
+    while (pov_renderer_step(&renderer))
+        ;
+
+    for (i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-v") == 0) {
+            verbose = 1;
+        }
+        else if (strcmp(argv[i], "-t") == 0) {
+            dump_trace = 1;
+        }
+        else if (strcmp(argv[i], "-i") == 0 && i + 1 < argc) {
+            image_dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            if (predictor_kind_from_name(argv[++i], &predictor_choice) < 0) {
+                fprintf(stderr, "Unknown predictor %s\n", argv[i]);
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            run_length = (uint)atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            // shown from the captures after it on, scrolling if it is too long for the display
+            if (pov_renderer_start(&renderer, argv[++i], MESSAGE_CHAR_SCALE, POV_DEFAULT_SCROLL, PIXEL_CHAR_COLOR,
+                                   PIXEL_BG_COLOR) < 0) {
+                fprintf(stderr, "Message %s does not fit\n", argv[i]);
+                return 1;
+            }
+            while (pov_renderer_step(&renderer))
+                ;
+        }
+        else {
+            if (simulate(argv[i], image_dir, &m) < 0)
+                return 1;
+            score_sum += m.score;
+            n_captures++;
+            printf("\n");
+        }
+    }
+
+    if (n_captures == 0) {
+        fprintf(stderr, "Usage: %s [-v] [-t] [-i image_dir] [-p last|ewma|pll] [-r run_length] [-m message] capture.csv [capture.csv ...]\n", argv[0]);
+        return 1;
+    }
+
+    printf("captures=%d\n", n_captures);
+    printf("corpus_score=%.2f\n", score_sum / n_captures);
+    return 0;
+}
@@ -3,27 +3,16 @@
 
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
+#include "hardware/spi.h"
 
 #include "ADXL343.h"
 
 
-// i2c buffer
-uint8_t buffer[2] = {0};
-
-int adxl343_setup(adxl343 *accelerometer, i2c_inst_t *i2c, uint8_t SDA_pin, uint8_t SCL_pin, uint8_t address)
+// checks the device is there, and configures it the same whatever the bus
+static int adxl343_configure(adxl343 *accelerometer)
 {
     int err;
 
-    // initialize i2c
-    i2c_init(i2c, 100 * 1000);  // select standard communication rate of 100kHz
-    gpio_set_function(SDA_pin, GPIO_FUNC_I2C);
-    gpio_set_function(SCL_pin, GPIO_FUNC_I2C);
-    gpio_pull_up(SDA_pin);
-    gpio_pull_up(SCL_pin);
-
-    accelerometer->address = address;
-    accelerometer->i2c = i2c;   
-
     // Confirm the device ID is correct
     uint8_t devid;
     err = adxl343_read_register_8(accelerometer, ADXL3XX_REG_DEVID, &devid);
@@ -36,7 +25,7 @@ int adxl343_setup(adxl343 *accelerometer, i2c_inst_t *i2c, uint8_t SDA_pin, uint
         return PICO_ERROR_GENERIC;
     }
 
-    // select the G-force range, 10-bit measurements: 0b0000 00xx
+    // select the G-force range, 10-bit measurements, and 4-wire SPI: 0b0000 00xx
     err = adxl343_write_register(accelerometer, ADXL3XX_REG_DATA_FORMAT, SELECTED_ADXL3XX_RANGE);
     if (err < 0) 
         return err;
@@ -50,48 +39,307 @@ int adxl343_setup(adxl343 *accelerometer, i2c_inst_t *i2c, uint8_t SDA_pin, uint
 }
 
 
+int adxl343_setup(adxl343 *accelerometer, i2c_inst_t *i2c, uint8_t SDA_pin, uint8_t SCL_pin, uint8_t address, uint baudrate)
+{
+    // initialize i2c
+    i2c_init(i2c, baudrate);
+    gpio_set_function(SDA_pin, GPIO_FUNC_I2C);
+    gpio_set_function(SCL_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(SDA_pin);
+    gpio_pull_up(SCL_pin);
+
+    accelerometer->bus = ADXL343_BUS_I2C;
+    accelerometer->address = address;
+    accelerometer->i2c = i2c;
+    accelerometer->spi = NULL;
+    accelerometer->mock = NULL;
+
+    return adxl343_configure(accelerometer);
+}
+
+
+int adxl343_setup_spi(adxl343 *accelerometer, spi_inst_t *spi, uint8_t SCK_pin, uint8_t MOSI_pin, uint8_t MISO_pin,
+                      uint8_t CS_pin, uint baudrate)
+{
+    // initialize SPI. The adxl343 wants mode 3, the clock idling high and data sampled on its rising edge
+    spi_init(spi, baudrate);
+    spi_set_format(spi, 8, SPI_CPOL_1, SPI_CPHA_1, SPI_MSB_FIRST);
+    gpio_set_function(SCK_pin, GPIO_FUNC_SPI);
+    gpio_set_function(MOSI_pin, GPIO_FUNC_SPI);
+    gpio_set_function(MISO_pin, GPIO_FUNC_SPI);
+
+    // the SPI peripheral would raise its own chip select between bytes, which would end a burst after the address
+    gpio_init(CS_pin);
+    gpio_put(CS_pin, 1);
+    gpio_set_dir(CS_pin, GPIO_OUT);
+
+    accelerometer->bus = ADXL343_BUS_SPI;
+    accelerometer->address = 0;
+    accelerometer->i2c = NULL;
+    accelerometer->spi = spi;
+    accelerometer->cs_pin = CS_pin;
+    accelerometer->mock = NULL;
+
+    return adxl343_configure(accelerometer);
+}
+
+
+void adxl343_mock_init(adxl343_mock *mock)
+{
+    int i;
+
+    for (i = 0; i <= ADXL3XX_REG_FIFO_STATUS; i++)
+        mock->regs[i] = 0;
+    mock->regs[ADXL3XX_REG_DEVID] = 0xe5;
+    mock->regs[ADXL3XX_REG_BW_RATE] = ADXL3XX_DATARATE_100_HZ;
+    mock->head = 0;
+    mock->n = 0;
+    mock->reads = 0;
+    mock->writes = 0;
+}
+
+
+void adxl343_mock_push(adxl343_mock *mock, const adxl343_xyz *sample)
+{
+    uint8_t mode = mock->regs[ADXL3XX_REG_FIFO_CTL] & 0xc0;
+
+    // without a FIFO there is only the data registers, which the new sample overwrites
+    if (mode == ADXL3XX_FIFO_MODE_BYPASS) {
+        mock->fifo[0] = *sample;
+        mock->head = 0;
+        mock->n = 1;
+        return;
+    }
+
+    if (mock->n == ADXL3XX_FIFO_SIZE) {
+        // stream mode makes room by dropping the oldest sample, the others stop collecting when full
+        if (mode != ADXL3XX_FIFO_MODE_STREAM)
+            return;
+        mock->head = (mock->head + 1) % ADXL3XX_FIFO_SIZE;
+        mock->n--;
+    }
+    mock->fifo[(mock->head + mock->n) % ADXL3XX_FIFO_SIZE] = *sample;
+    mock->n++;
+}
+
+
+int adxl343_setup_mock(adxl343 *accelerometer, adxl343_mock *mock)
+{
+    accelerometer->bus = ADXL343_BUS_MOCK;
+    accelerometer->address = 0;
+    accelerometer->i2c = NULL;
+    accelerometer->spi = NULL;
+    accelerometer->mock = mock;
+
+    return adxl343_configure(accelerometer);
+}
+
+
+// reads a register of the mock, with the data registers showing the oldest sample
+static uint8_t adxl343_mock_read(adxl343_mock *mock, uint8_t reg)
+{
+    const adxl343_xyz *sample = &mock->fifo[mock->head];
+    int16_t axis;
+
+    if (reg > ADXL3XX_REG_FIFO_STATUS)
+        return 0;
+    if (reg == ADXL3XX_REG_FIFO_STATUS)
+        return (mock->regs[ADXL3XX_REG_FIFO_CTL] & 0xc0) == ADXL3XX_FIFO_MODE_BYPASS ? 0 : mock->n;
+    if (reg < ADXL3XX_REG_DATAX0 || reg > ADXL3XX_REG_DATAZ1)
+        return mock->regs[reg];
+
+    if (mock->n == 0)
+        return 0;
+    switch ((reg - ADXL3XX_REG_DATAX0) / 2) {
+        case 0: axis = sample->x; break;
+        case 1: axis = sample->y; break;
+        default: axis = sample->z; break;
+    }
+    return (reg - ADXL3XX_REG_DATAX0) & 1 ? (uint16_t)axis >> 8 : axis & 0xff;
+}
+
+
+static int adxl343_mock_read_registers(adxl343_mock *mock, uint8_t reg, uint8_t *out_vals, size_t len)
+{
+    size_t i;
+
+    mock->reads++;
+    for (i = 0; i < len; i++)
+        out_vals[i] = adxl343_mock_read(mock, reg + i);
+
+    // reading the last data register pops the FIFO, the next sample moves into the data registers
+    if (reg <= ADXL3XX_REG_DATAZ1 && reg + len > ADXL3XX_REG_DATAZ1 && mock->n > 0 &&
+        (mock->regs[ADXL3XX_REG_FIFO_CTL] & 0xc0) != ADXL3XX_FIFO_MODE_BYPASS) {
+        mock->head = (mock->head + 1) % ADXL3XX_FIFO_SIZE;
+        mock->n--;
+    }
+    return len;
+}
+
+
+static int adxl343_mock_write_register(adxl343_mock *mock, uint8_t reg, uint8_t value)
+{
+    mock->writes++;
+
+    // the ID, the interrupt sources and the data are read only
+    if (reg > ADXL3XX_REG_FIFO_CTL || reg == ADXL3XX_REG_DEVID || reg == ADXL3XX_REG_INT_SOURCE ||
+        (reg >= ADXL3XX_REG_DATAX0 && reg <= ADXL3XX_REG_DATAZ1))
+        return 2;
+
+    // bypass clears the FIFO, leaving the newest sample in the data registers
+    if (reg == ADXL3XX_REG_FIFO_CTL && (value & 0xc0) == ADXL3XX_FIFO_MODE_BYPASS && mock->n > 0) {
+        mock->fifo[0] = mock->fifo[(mock->head + mock->n - 1) % ADXL3XX_FIFO_SIZE];
+        mock->head = 0;
+        mock->n = 1;
+    }
+    mock->regs[reg] = value;
+    return 2;
+}
+
+
 int adxl343_write_register(adxl343 *accelerometer, uint8_t reg, uint8_t value)
 {
     int err;
+    uint8_t buffer[2];
 
     buffer[0] = reg;
     buffer[1] = value;
-    err = i2c_write_timeout_us(accelerometer->i2c, accelerometer->address, buffer, 2, false, ADXL343_I2C_TIMEOUT_US);
-    
+
+    switch (accelerometer->bus) {
+        case ADXL343_BUS_SPI:
+            gpio_put(accelerometer->cs_pin, 0);
+            spi_write_blocking(accelerometer->spi, buffer, 2);
+            gpio_put(accelerometer->cs_pin, 1);
+            err = 2;
+            break;
+        case ADXL343_BUS_MOCK:
+            err = adxl343_mock_write_register(accelerometer->mock, reg, value);
+            break;
+        default:
+            err = i2c_write_timeout_us(accelerometer->i2c, accelerometer->address, buffer, 2, false, ADXL343_I2C_TIMEOUT_US);
+            break;
+    }
+
     return err;
 }
 
 
-int adxl343_read_register_8(adxl343 *accelerometer, uint8_t reg, uint8_t *out_val)
+int adxl343_set_data_rate(adxl343 *accelerometer, uint8_t data_rate)
+{
+    return adxl343_write_register(accelerometer, ADXL3XX_REG_BW_RATE, data_rate & (ADXL3XX_LOW_POWER | 0x0f));
+}
+
+
+int adxl343_set_interrupts(adxl343 *accelerometer, uint8_t int_enable, uint8_t int2_map)
 {
     int err;
 
-    buffer[0] = reg;
+    // map the interrupts before enabling them, so they never fire on the wrong pin
+    err = adxl343_write_register(accelerometer, ADXL3XX_REG_INT_MAP, int2_map);
+    if (err < 0)
+        return err;
 
-    // request the register
-    err = i2c_write_timeout_us(accelerometer->i2c, accelerometer->address, buffer, 1, true, ADXL343_I2C_TIMEOUT_US);
-    if (err < 0) 
+    return adxl343_write_register(accelerometer, ADXL3XX_REG_INT_ENABLE, int_enable);
+}
+
+
+int adxl343_set_activity(adxl343 *accelerometer, uint8_t act_thresh, uint8_t inact_thresh, uint8_t inact_time_s)
+{
+    int err;
+
+    err = adxl343_write_register(accelerometer, ADXL3XX_REG_THRESH_ACT, act_thresh);
+    if (err >= 0)
+        err = adxl343_write_register(accelerometer, ADXL3XX_REG_THRESH_INACT, inact_thresh);
+    if (err >= 0)
+        err = adxl343_write_register(accelerometer, ADXL3XX_REG_TIME_INACT, inact_time_s);
+    if (err < 0)
         return err;
 
-    // read from that register
-    err = i2c_read_timeout_us(accelerometer->i2c, accelerometer->address, out_val, 1, false, ADXL343_I2C_TIMEOUT_US);
+    return adxl343_write_register(accelerometer, ADXL3XX_REG_ACT_INACT_CTL,
+                                  ADXL3XX_ACT_AC | ADXL3XX_ACT_XYZ | ADXL3XX_INACT_AC | ADXL3XX_INACT_XYZ);
+}
+
+
+int adxl343_get_int_source(adxl343 *accelerometer, uint8_t *source)
+{
+    return adxl343_read_register_8(accelerometer, ADXL3XX_REG_INT_SOURCE, source);
+}
+
+
+int adxl343_set_fifo(adxl343 *accelerometer, uint8_t mode, uint8_t samples)
+{
+    int err;
+
+    // a larger count would wrap into the trigger bit
+    if (samples > ADXL3XX_FIFO_SAMPLES_MAX)
+        return PICO_ERROR_GENERIC;
+
+    // changing the mode through bypass clears the FIFO, and re-arms trigger mode
+    err = adxl343_write_register(accelerometer, ADXL3XX_REG_FIFO_CTL, ADXL3XX_FIFO_MODE_BYPASS);
+    if (err < 0)
+        return err;
+
+    return adxl343_write_register(accelerometer, ADXL3XX_REG_FIFO_CTL, (mode & 0xe0) | samples);
+}
+
+
+int adxl343_get_fifo_status(adxl343 *accelerometer, uint8_t *entries, bool *triggered)
+{
+    int err;
+    uint8_t status;
+
+    err = adxl343_read_register_8(accelerometer, ADXL3XX_REG_FIFO_STATUS, &status);
+    if (err < 0)
+        return err;
+
+    *entries = status & 0x3f;
+    if (triggered != NULL)
+        *triggered = (status & 0x80) != 0;
     return err;
 }
 
 
-int adxl343_read_register_16(adxl343 *accelerometer, uint8_t reg, int16_t *out_val)
+int adxl343_read_fifo(adxl343 *accelerometer, adxl343_xyz *out_vals, size_t max_samples, size_t *n_read)
 {
     int err;
+    uint8_t entries;
+    size_t i;
 
-    buffer[0] = reg;
+    *n_read = 0;
 
-    // request the register
-    err = i2c_write_timeout_us(accelerometer->i2c, accelerometer->address, buffer, 1, true, ADXL343_I2C_TIMEOUT_US);
-    if (err < 0) 
+    err = adxl343_get_fifo_status(accelerometer, &entries, NULL);
+    if (err < 0)
         return err;
 
+    // entries counts the sample waiting in the data registers too, which ADXL3XX_FIFO_SIZE already allows for, so it
+    // is at most ADXL3XX_FIFO_SIZE
+    for (i = 0; i < entries && i < max_samples; i++) {
+        // each entry must be read as one burst of all three axes, which pops it off the FIFO
+        err = adxl343_read_xyz(accelerometer, &out_vals[i]);
+        if (err < 0)
+            return err;
+        (*n_read)++;
+    }
+
+    return err;
+}
+
+
+int adxl343_read_register_8(adxl343 *accelerometer, uint8_t reg, uint8_t *out_val)
+{
+    return adxl343_read_registers(accelerometer, reg, out_val, 1);
+}
+
+
+int adxl343_read_register_16(adxl343 *accelerometer, uint8_t reg, int16_t *out_val)
+{
+    int err;
+    uint8_t buffer[2];
+
     // read from that register, and the one immediately after it
-    err = i2c_read_timeout_us(accelerometer->i2c, accelerometer->address, buffer, 2, false, ADXL343_I2C_TIMEOUT_US);
+    err = adxl343_read_registers(accelerometer, reg, buffer, 2);
+    if (err < 0)
+        return err;
 
     // squash buffer[0] and buffer[1] into out_val, using the first register as LSByte and second register as MSByte
     *out_val = (buffer[0]) | (buffer[1] << 8);
@@ -99,6 +347,37 @@ int adxl343_read_register_16(adxl343 *accelerometer, uint8_t reg, int16_t *out_v
 }
 
 
+int adxl343_read_registers(adxl343 *accelerometer, uint8_t reg, uint8_t *out_vals, size_t len)
+{
+    int err;
+    uint8_t command;
+
+    switch (accelerometer->bus) {
+        case ADXL343_BUS_SPI:
+            // the address byte says read, and whether to increment the address after every byte for a burst
+            command = (reg & 0x3f) | ADXL343_SPI_READ | (len > 1 ? ADXL343_SPI_MULTI_BYTE : 0);
+            gpio_put(accelerometer->cs_pin, 0);
+            spi_write_blocking(accelerometer->spi, &command, 1);
+            spi_read_blocking(accelerometer->spi, 0, out_vals, len);
+            gpio_put(accelerometer->cs_pin, 1);
+            return len;
+        case ADXL343_BUS_MOCK:
+            return adxl343_mock_read_registers(accelerometer->mock, reg, out_vals, len);
+        default:
+            break;
+    }
+
+    // request the register, keeping control of the bus for the read
+    err = i2c_write_timeout_us(accelerometer->i2c, accelerometer->address, &reg, 1, true, ADXL343_I2C_TIMEOUT_US);
+    if (err < 0) 
+        return err;
+
+    // the adxl343 increments the register address after every byte, so the following registers come along with it
+    err = i2c_read_timeout_us(accelerometer->i2c, accelerometer->address, out_vals, len, false, ADXL343_I2C_TIMEOUT_US);
+    return err;
+}
+
+
 int adxl343_getx(adxl343 *accelerometer, int16_t *out_val)
 {
     return adxl343_read_register_16(accelerometer, ADXL3XX_REG_DATAX0, out_val);
@@ -114,4 +393,21 @@ int adxl343_gety(adxl343 *accelerometer, int16_t *out_val)
 int adxl343_getz(adxl343 *accelerometer, int16_t *out_val)
 {
     return adxl343_read_register_16(accelerometer, ADXL3XX_REG_DATAZ0, out_val);
+}
+
+
+int adxl343_read_xyz(adxl343 *accelerometer, adxl343_xyz *out_vals)
+{
+    int err;
+    uint8_t buffer[6];
+
+    // DATAX0 through DATAZ1 in one transaction
+    err = adxl343_read_registers(accelerometer, ADXL3XX_REG_DATAX0, buffer, 6);
+    if (err < 0)
+        return err;
+
+    out_vals->x = (buffer[0]) | (buffer[1] << 8);
+    out_vals->y = (buffer[2]) | (buffer[3] << 8);
+    out_vals->z = (buffer[4]) | (buffer[5] << 8);
+    return err;
 }
\ No newline at end of file
@@ -1,17 +1,18 @@
 /*
 Main C file for the accelerometer data acquisition build target
-Sends the Z-axis acceleration and system time over serial
+Streams every sample the accelerometer produces over serial as binary telemetry packets, see inc/telemetry.h
 */
 
 #include <stdio.h>
 #include <stdlib.h>
 
 #include "pico/stdlib.h"
-#include "pico/double.h"
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
+#include "hardware/spi.h"
 
 #include "ADXL343.h"
+#include "telemetry.h"
 
 
 // gpio pin defines
@@ -19,9 +20,40 @@ Sends the Z-axis acceleration and system time over serial
 #define ADX_SDA_PIN     16
 #define ADX_SCL_PIN     17
 
+// the accelerometer is on i2c as built. -DADX_USE_SPI=1 for one wired for 4-wire SPI on spi0 instead
+#ifndef ADX_USE_SPI
+#define ADX_USE_SPI     0
+#endif
+#define ADX_SCK_PIN     22
+#define ADX_MOSI_PIN    19
+#define ADX_MISO_PIN    16
+#define ADX_CS_PIN      17
+
+// sample at the same rate as the light wand, so the captures can be replayed through the simulator as they are
+#ifndef ACCEL_DATA_RATE
+#define ACCEL_DATA_RATE         ADXL3XX_DATARATE_800_HZ
+#define ACCEL_SAMPLE_PERIOD_US  (1000000 / 800)
+#endif
+
+// send a packet at least this often, so a capture can be stopped without losing much
+#define PACKET_SAMPLES          TELEMETRY_MAX_SAMPLES
+
+
+// sends a finished packet without any newline translation
+static void send_packet(telemetry_packet *packet)
+{
+    const uint8_t *buf;
+    size_t i, len;
+
+    len = telemetry_finish(packet, &buf);
+    for (i = 0; i < len; i++)
+        putchar_raw(buf[i]);
+}
+
+
 int main()
 {
-    int i, err;
+    int err;
 
     stdio_init_all();
 
@@ -38,22 +70,61 @@ int main()
     printf("Starting...\n");
     // initialize the accelerometer
     adxl343 accelerometer;
-    err = adxl343_setup(&accelerometer, i2c0, ADX_SDA_PIN, ADX_SCL_PIN, ADXL343_DEFAULT_ADDRESS);
+#if ADX_USE_SPI
+    err = adxl343_setup_spi(&accelerometer, spi0, ADX_SCK_PIN, ADX_MOSI_PIN, ADX_MISO_PIN, ADX_CS_PIN, ADXL343_SPI_MAX_HZ);
+#else
+    err = adxl343_setup(&accelerometer, i2c0, ADX_SDA_PIN, ADX_SCL_PIN, ADXL343_DEFAULT_ADDRESS, ADXL343_I2C_FAST_MODE_HZ);
+#endif
     if (err < 0) {
         printf("ADXL343 Setup failed... error %d\n", err);
     }
+
+    // let samples collect in the FIFO while a packet is being sent, so none are missed
+    adxl343_set_data_rate(&accelerometer, ACCEL_DATA_RATE);
+    adxl343_set_fifo(&accelerometer, ADXL3XX_FIFO_MODE_STREAM, 16);
     printf("Accelerometer setup complete...\n");  
 
-    int16_t ax_raw;
-    double accel_mss = 0;
+    adxl343_xyz samples[ADXL3XX_FIFO_SIZE];
+    size_t n_samples, i;
+    telemetry_packet packet;
+    telemetry_init(&packet);
+    // time the newest sample sent so far was measured, 0 until the first
+    uint64_t last_us = 0;
 
     while (1) {
-        // update raw adx reading
-        adxl343_getx(&accelerometer, &ax_raw);
+        uint64_t now, newest_us;
+        bool overflow;
+
+        // drain whatever has collected in the FIFO. The newest sample was measured within a sample period of now
+        now = time_us_64();
+        err = adxl343_read_fifo(&accelerometer, samples, ADXL3XX_FIFO_SIZE, &n_samples);
+        if (err < 0 || n_samples == 0)
+            continue;
+
+        // a full FIFO in stream mode has been dropping its oldest samples
+        overflow = n_samples == ADXL3XX_FIFO_SIZE;
+        if (overflow)
+            telemetry_set_flags(&packet, TELEMETRY_FLAG_OVERFLOW);
+
+        // the samples follow on from the last batch at the data rate, unless some were lost in between or the
+        // accelerometer's clock has drifted from the pico's, see inc/telemetry.h
+        newest_us = last_us + (uint64_t)n_samples * ACCEL_SAMPLE_PERIOD_US;
+        if (last_us == 0 || overflow || newest_us > now + ACCEL_SAMPLE_PERIOD_US ||
+            newest_us + 2 * ACCEL_SAMPLE_PERIOD_US < now) {
+            newest_us = now;
+            telemetry_set_flags(&packet, TELEMETRY_FLAG_RESYNC);
+        }
+        last_us = newest_us;
 
-        // convert to acceleration in meters/s^2
-        accel_mss = (double)ax_raw * ADXL3XXVAL_TO_MSS;
+        for (i = 0; i < n_samples; i++) {
+            uint64_t t_us = newest_us - (uint64_t)(n_samples - 1 - i) * ACCEL_SAMPLE_PERIOD_US;
 
-        printf("%f,%d\n", accel_mss, time_us_64());
+            if (telemetry_add_sample(&packet, t_us, &samples[i]) < 0) {
+                send_packet(&packet);
+                telemetry_add_sample(&packet, t_us, &samples[i]);
+            }
+            if (packet.n_samples == PACKET_SAMPLES)
+                send_packet(&packet);
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,318 @@
+/*
+Main C file for the micro-benchmark build target
+Times the compute kernels on the firmware's hot paths, so a change to one of them can be checked for speed as well as
+correctness. The same file builds for the RP2040 (the light-wand-bench target of the firmware build, results in
+processor cycles counted by SysTick, printed over USB every few seconds) and for the host (light-wand-bench in the
+simulator build, results in ns).
+
+Every kernel is run on BENCH_ITEMS items (samples, pixels or columns) BENCH_REPEATS times. The fastest and the mean
+time per item are printed one kernel per line, as key=value pairs in a fixed order, so two runs can be diffed:
+
+    bench=<kernel> per=<item> items=<n> repeats=<n> min=<time> mean=<time> budget=<cycles> status=ok|over|host
+
+On the RP2040 a kernel whose fastest run goes over its cycle budget is marked 'over'. The budgets are per item at
+125MHz and leave the hot paths their share of the time between samples and columns:
+
+    urgbw_u32                   colour conversion into the strips' pixel format, per pixel
+    pov_update_direction        the detector's step, per sample: jerk and hysteresis, and at the two reversals in
+                                BENCH_SAMPLES the predictor and signalling core 1, which are spread over the samples.
+                                Core 0 has 156k cycles per sample at 800Hz, but also runs the sampler's interrupts
+    pov_fit_profile             velocity profile fit, per half swing of BENCH_SWING_SAMPLES / 2 samples. Runs once
+                                per reversal, so it is given an eighth of a 10ms batch
+    build_columns               text layout, per display column
+    ws2812_mask_column          column mask to pixels, per column
+    ws2812_transpose_column     bit planes for parallel strips, per column. Runs in the column alarm interrupt
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "neopixels.h"
+#include "pov.h"
+
+#ifdef LIGHT_WAND_HOST
+#include <time.h>
+#else
+#include "hardware/clocks.h"
+#include "hardware/structs/systick.h"
+#include "pico/stdio_usb.h"
+#endif
+
+#define BENCH_REPEATS           32
+#define BENCH_SAMPLES           1000    // two swings of the synthetic wand
+#define BENCH_PIXELS            1024
+#define BENCH_COLUMNS           16
+#define BENCH_HALF_SWINGS       4
+#define BENCH_PRINT_PERIOD_MS   5000
+
+// cycle budgets per item, see above
+#define BUDGET_URGBW            8
+#define BUDGET_DIRECTION        250
+#define BUDGET_FIT_PROFILE      156000
+#define BUDGET_BUILD_COLUMNS    150
+#define BUDGET_MASK_COLUMN      300
+#define BUDGET_TRANSPOSE        12000
+
+// samples of a wand swinging at 1.6Hz sampled at 800Hz, with a little noise
+#define BENCH_SWING_SAMPLES     500
+#define BENCH_SWING_AMPLITUDE   400
+
+typedef void (*bench_kernel_fn)(int n);
+
+// results are folded into here, so the compiler can't throw the kernels away
+static volatile uint32_t bench_sink;
+
+static int16_t swing_samples[BENCH_SAMPLES];
+static uint8_t channels[BENCH_PIXELS + 3];
+static uint32_t columns_in[BENCH_COLUMNS][WS2812_COLUMN_PIXELS];
+static uint32_t columns_out[BENCH_COLUMNS][WS2812_COLUMN_PIXELS];
+static uint32_t planes[WS2812_N_PIXELS * 32];
+static uint32_t display_columns[N_DISPLAY_COLUMNS];
+static pov_detector detector;
+static pov_detector fit_detector;
+static uint64_t sample_us;
+
+
+#ifdef LIGHT_WAND_HOST
+#define BENCH_PLATFORM  "host"
+#define BENCH_UNIT      "ns"
+
+static inline uint32_t bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec);
+}
+
+static inline uint32_t bench_elapsed(uint32_t start, uint32_t end)
+{
+    return end - start;
+}
+#else
+#define BENCH_PLATFORM  "rp2040"
+#define BENCH_UNIT      "cycles"
+
+// SysTick counts processor cycles down from 2^24 - 1, which is plenty for one run of any kernel
+static inline uint32_t bench_now(void)
+{
+    return systick_hw->cvr;
+}
+
+static inline uint32_t bench_elapsed(uint32_t start, uint32_t end)
+{
+    return (start - end) & M0PLUS_SYST_RVR_BITS;
+}
+#endif
+
+
+static void bench_urgbw(int n)
+{
+    uint32_t acc = 0;
+    int i;
+
+    for (i = 0; i < n; i++)
+        acc ^= urgbw_u32(channels[i], channels[i + 1], channels[i + 2], channels[i + 3]);
+    bench_sink = acc;
+}
+
+
+static void bench_direction(int n)
+{
+    uint32_t acc = 0;
+    int i;
+
+    // the clock keeps running from one run to the next, as the detector expects
+    for (i = 0; i < n; i++) {
+        sample_us += ADX_SAMPLE_PERIOD_US;
+        acc += pov_update_direction(&detector, sample_us, swing_samples[i]);
+    }
+    bench_sink = acc;
+}
+
+
+static void bench_fit_profile(int n)
+{
+    int i;
+
+    // the same half swing, from the trough of the acceleration to its peak, is fitted each time
+    for (i = 0; i < n; i++) {
+        fit_detector.fit_pending = true;
+        fit_detector.fit_dir = 0;
+        fit_detector.fit_n = BENCH_SWING_SAMPLES;
+        fit_detector.reversal_n = BENCH_SWING_SAMPLES + BENCH_SWING_SAMPLES / 2;
+        pov_fit_profile(&fit_detector);
+    }
+    bench_sink = fit_detector.profile[0][N_DISPLAY_COLUMNS / 2];
+}
+
+
+static void bench_build_columns(int n)
+{
+    build_columns(POV_DEFAULT_TEXT, display_columns, n, MESSAGE_CHAR_SCALE);
+    bench_sink = display_columns[n / 2];
+}
+
+
+static void bench_mask_column(int n)
+{
+    uint32_t acc = 0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        ws2812_mask_column(columns_in[i][0], columns_in[i][1], columns_in[i][2], columns_out[i]);
+        acc ^= columns_out[i][WS2812_COLUMN_PIXELS - 1];
+    }
+    bench_sink = acc;
+}
+
+
+static void bench_transpose(int n)
+{
+    uint32_t acc = 0;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        ws2812_transpose_column(columns_in[i], planes);
+        acc ^= planes[0];
+    }
+    bench_sink = acc;
+}
+
+
+static void bench_empty(int n)
+{
+    bench_sink = (uint32_t)n;
+}
+
+
+// times kernel over n items BENCH_REPEATS times, less the cost of timing an empty kernel
+static void bench_run(bench_kernel_fn kernel, int n, uint32_t overhead, uint32_t *min, uint64_t *total)
+{
+    uint32_t start, t;
+    int r;
+
+    *min = UINT32_MAX;
+    *total = 0;
+    for (r = 0; r < BENCH_REPEATS; r++) {
+        start = bench_now();
+        kernel(n);
+        t = bench_elapsed(start, bench_now());
+        t = t > overhead ? t - overhead : 0;
+        if (t < *min)
+            *min = t;
+        *total += t;
+    }
+}
+
+
+static void bench_report(const char *name, const char *per, bench_kernel_fn kernel, int n, uint32_t budget, uint32_t overhead)
+{
+    uint32_t min;
+    uint64_t total;
+    double min_per_item, mean_per_item;
+
+    bench_run(kernel, n, overhead, &min, &total);
+    min_per_item = (double)min / n;
+    mean_per_item = (double)total / BENCH_REPEATS / n;
+
+#ifdef LIGHT_WAND_HOST
+    const char *status = "host";
+#else
+    const char *status = min_per_item <= budget ? "ok" : "over";
+#endif
+
+    printf("bench=%s per=%s items=%d repeats=%d min=%.2f mean=%.2f budget=%u status=%s\n", name, per, n, BENCH_REPEATS,
+           min_per_item, mean_per_item, (unsigned)budget, status);
+}
+
+
+static void bench_setup(void)
+{
+    uint32_t lcg = 12345;
+    int i, j;
+
+    // a triangle wave is close enough to a swing for the detector, and needs no floating point
+    for (i = 0; i < BENCH_SAMPLES; i++) {
+        int phase = i % BENCH_SWING_SAMPLES;
+        int tri = phase < BENCH_SWING_SAMPLES / 2 ? phase : BENCH_SWING_SAMPLES - phase;
+
+        lcg = lcg * 1664525u + 1013904223u;
+        swing_samples[i] = (int16_t)(tri * 4 * BENCH_SWING_AMPLITUDE / BENCH_SWING_SAMPLES - BENCH_SWING_AMPLITUDE +
+                                     (int)(lcg >> 29) - 4);
+    }
+
+    for (i = 0; i < BENCH_PIXELS + 3; i++) {
+        lcg = lcg * 1664525u + 1013904223u;
+        channels[i] = (uint8_t)(lcg >> 24);
+    }
+
+    for (i = 0; i < BENCH_COLUMNS; i++) {
+        for (j = 0; j < WS2812_COLUMN_PIXELS; j++) {
+            lcg = lcg * 1664525u + 1013904223u;
+            columns_in[i][j] = lcg;
+        }
+    }
+
+    pov_detector_init(&detector);
+    pov_swing_ring_init(&pov_swings);
+    sample_us = 0;
+
+    // the fit reads the samples straight out of the detector's ring
+    pov_detector_init(&fit_detector);
+    for (i = 0; i < BENCH_SAMPLES; i++)
+        fit_detector.samples[i % POV_PROFILE_SAMPLES] = swing_samples[i];
+    fit_detector.n_samples = BENCH_SAMPLES;
+
+#ifndef LIGHT_WAND_HOST
+    systick_hw->rvr = M0PLUS_SYST_RVR_BITS;
+    systick_hw->cvr = 0;
+    systick_hw->csr = M0PLUS_SYST_CSR_ENABLE_BITS | M0PLUS_SYST_CSR_CLKSOURCE_BITS;
+#endif
+}
+
+
+static void bench_all(void)
+{
+    uint32_t overhead;
+    uint64_t total;
+
+    bench_run(bench_empty, 1, 0, &overhead, &total);
+
+#ifdef LIGHT_WAND_HOST
+    printf("bench_platform=%s unit=%s\n", BENCH_PLATFORM, BENCH_UNIT);
+#else
+    printf("bench_platform=%s unit=%s clock_hz=%u\n", BENCH_PLATFORM, BENCH_UNIT, (unsigned)clock_get_hz(clk_sys));
+#endif
+    bench_report("urgbw_u32", "pixel", bench_urgbw, BENCH_PIXELS, BUDGET_URGBW, overhead);
+    bench_report("pov_update_direction", "sample", bench_direction, BENCH_SAMPLES, BUDGET_DIRECTION, overhead);
+    bench_report("pov_fit_profile", "half_swing", bench_fit_profile, BENCH_HALF_SWINGS, BUDGET_FIT_PROFILE, overhead);
+    bench_report("build_columns", "column", bench_build_columns, N_DISPLAY_COLUMNS, BUDGET_BUILD_COLUMNS, overhead);
+    bench_report("ws2812_mask_column", "column", bench_mask_column, BENCH_COLUMNS, BUDGET_MASK_COLUMN, overhead);
+    bench_report("ws2812_transpose_column", "column", bench_transpose, BENCH_COLUMNS, BUDGET_TRANSPOSE, overhead);
+}
+
+
+int main()
+{
+    bench_setup();
+
+#ifdef LIGHT_WAND_HOST
+    bench_all();
+#else
+    stdio_init_all();
+    while (1) {
+        // only print once someone is listening, so the first results aren't lost
+        while (!stdio_usb_connected())
+            sleep_ms(100);
+        bench_all();
+        printf("\n");
+        sleep_ms(BENCH_PRINT_PERIOD_MS);
+    }
+#endif
+
+    return 0;
+}
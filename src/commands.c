@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "commands.h"
+#include "sampler.h"
+#include "trace.h"
+
+
+void command_reader_init(command_reader *reader)
+{
+    reader->len = 0;
+    reader->overflowed = false;
+}
+
+
+const char *command_poll(command_reader *reader)
+{
+    int c;
+
+    while ((c = getchar_timeout_us(0)) != PICO_ERROR_TIMEOUT) {
+        if (c == '\r' || c == '\n') {
+            bool overflowed = reader->overflowed;
+
+            reader->line[reader->len] = '\0';
+            reader->len = 0;
+            reader->overflowed = false;
+
+            if (overflowed) {
+                printf("ERR too long\n");
+                continue;
+            }
+            if (reader->line[0] != '\0')
+                return reader->line;
+            continue;
+        }
+
+        // throw away the rest of a line that is too long, rather than act on half of it
+        if (reader->len == COMMAND_MAX_LEN)
+            reader->overflowed = true;
+        else
+            reader->line[reader->len++] = (char)c;
+    }
+
+    return NULL;
+}
+
+
+// parses four 0-255 channels
+static int parse_color(const char *args, uint32_t *color)
+{
+    unsigned r, g, b, w;
+
+    if (sscanf(args, "%u %u %u %u", &r, &g, &b, &w) != 4 || r > 255 || g > 255 || b > 255 || w > 255)
+        return -1;
+
+    *color = urgbw_u32(r, g, b, w);
+    return 0;
+}
+
+
+int command_execute(const char *line, pov_renderer *renderer)
+{
+    char text[POV_MAX_TEXT_LEN + 1];
+    int scale = renderer->scale;
+    int scroll = renderer->scroll;
+    uint32_t color_on = renderer->color_on;
+    uint32_t color_off = renderer->color_off;
+    const image *img;
+
+    // start from the current settings, and change only what the command asks for
+    strcpy(text, renderer->text);
+
+    if (strncmp(line, "MSG ", 4) == 0) {
+        if (strlen(line + 4) > POV_MAX_TEXT_LEN) {
+            printf("ERR too long\n");
+            return -1;
+        }
+        strcpy(text, line + 4);
+    }
+    else if (strncmp(line, "SCALE ", 6) == 0) {
+        if (sscanf(line + 6, "%d", &scale) != 1 || scale < 1) {
+            printf("ERR bad scale\n");
+            return -1;
+        }
+    }
+    else if (strncmp(line, "SCROLL ", 7) == 0) {
+        if (sscanf(line + 7, "%d", &scroll) != 1 || scroll < 0 || scroll > N_DISPLAY_COLUMNS) {
+            printf("ERR bad scroll\n");
+            return -1;
+        }
+    }
+    else if (strncmp(line, "FG ", 3) == 0) {
+        if (parse_color(line + 3, &color_on) < 0) {
+            printf("ERR bad colour\n");
+            return -1;
+        }
+    }
+    else if (strncmp(line, "BG ", 3) == 0) {
+        if (parse_color(line + 3, &color_off) < 0) {
+            printf("ERR bad colour\n");
+            return -1;
+        }
+    }
+    else if (strncmp(line, "IMG ", 4) == 0) {
+        img = image_find(line + 4);
+        if (img == NULL) {
+            printf("ERR unknown image\n");
+            return -1;
+        }
+        if (pov_renderer_start_image(renderer, img, color_off) < 0) {
+            printf("ERR does not fit\n");
+            return -1;
+        }
+        printf("OK\n");
+        return 0;
+    }
+    else if (strcmp(line, "STATS") == 0) {
+        printf("SWINGS %u\nDECIMATED %u\nOVERRUNS %u\nCOLUMNS_CUT %u\nCOLUMNS_DROPPED %u\nLAST %u/%d\n",
+               (unsigned)pov_stats.swings, (unsigned)pov_stats.decimated, (unsigned)pov_stats.overruns,
+               (unsigned)pov_stats.columns_cut, (unsigned)pov_stats.columns_dropped, (unsigned)pov_stats.last_columns,
+               N_DISPLAY_COLUMNS);
+        printf("SAMPLES %u\nSAMPLES_DROPPED %u\nSENSOR_TIMEOUTS %u\nSENSOR_STALLS %u\nSENSOR_RESYNCS %u\nOK\n",
+               (unsigned)sampler_stats.samples, (unsigned)sampler_stats.dropped, (unsigned)sampler_stats.timeouts,
+               (unsigned)sampler_stats.stalls, (unsigned)sampler_stats.resyncs);
+        return 0;
+    }
+    else if (strcmp(line, "TRACE") == 0) {
+        trace_dump();
+        printf("OK\n");
+        return 0;
+    }
+    else if (strcmp(line, "TRACE CLEAR") == 0) {
+        trace_clear();
+        printf("OK\n");
+        return 0;
+    }
+    else if (strcmp(line, "GET") == 0) {
+        printf("MSG %s\nSCALE %d\nSCROLL %d\nFG 0x%08x\nBG 0x%08x\n", renderer->text, renderer->scale,
+               renderer->scroll, (unsigned)renderer->color_on, (unsigned)renderer->color_off);
+        if (renderer->image != NULL)
+            printf("IMG %s\n", renderer->image->name);
+        printf("OK\n");
+        return 0;
+    }
+    else {
+        printf("ERR unknown command\n");
+        return -1;
+    }
+
+    if (pov_renderer_start(renderer, text, scale, scroll, color_on, color_off) < 0) {
+        printf("ERR does not fit\n");
+        return -1;
+    }
+
+    printf("OK\n");
+    return 0;
+}
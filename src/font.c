@@ -0,0 +1,83 @@
+#include "pico/stdlib.h"
+
+#include "font.h"
+
+
+int font_decode_utf8(const char *s, uint32_t *codepoint)
+{
+    const uint8_t *u = (const uint8_t *)s;
+    uint32_t cp;
+    int n, i;
+
+    if (u[0] == 0) {
+        *codepoint = 0;
+        return 0;
+    }
+
+    // the lead byte gives the length of the sequence
+    if (u[0] < 0x80) {
+        *codepoint = u[0];
+        return 1;
+    } else if ((u[0] & 0xe0) == 0xc0) {
+        cp = u[0] & 0x1f;
+        n = 2;
+    } else if ((u[0] & 0xf0) == 0xe0) {
+        cp = u[0] & 0x0f;
+        n = 3;
+    } else if ((u[0] & 0xf8) == 0xf0) {
+        cp = u[0] & 0x07;
+        n = 4;
+    } else {
+        *codepoint = '?';
+        return 1;
+    }
+
+    for (i = 1; i < n; i++) {
+        // also stops at the terminator, which is not a continuation byte
+        if ((u[i] & 0xc0) != 0x80) {
+            *codepoint = '?';
+            return 1;
+        }
+        cp = (cp << 6) | (u[i] & 0x3f);
+    }
+
+    *codepoint = cp;
+    return n;
+}
+
+
+const font_glyph *font_find_glyph(uint32_t codepoint)
+{
+    int lo = 0, hi = FONT_N_EXTRAS - 1, mid;
+
+    if (codepoint < 128)
+        return &font_glyphs[font_ascii[codepoint]];
+
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (font_extras[mid].codepoint == codepoint)
+            return &font_glyphs[font_extras[mid].glyph];
+        if (font_extras[mid].codepoint < codepoint)
+            lo = mid + 1;
+        else
+            hi = mid - 1;
+    }
+
+    return &font_glyphs[font_ascii['?']];
+}
+
+
+int font_text_width(const char *text, int scale)
+{
+    uint32_t cp;
+    int n, width = 0;
+
+    while ((n = font_decode_utf8(text, &cp)) > 0) {
+        if (width > 0)
+            width += FONT_SPACING;
+        width += font_find_glyph(cp)->width;
+        text += n;
+    }
+
+    return width * scale;
+}
@@ -0,0 +1,191 @@
+/*
+Generated by scripts/generate_alphabet.py from DejaVuSans-Bold.ttf (size 15, offset 1,-3)
+Do not edit by hand, see inc/font.h for the layout
+*/
+
+#include "font.h"
+
+#if FONT_N_COLUMNS != 763 || FONT_N_GLYPHS != 96 || FONT_N_EXTRAS != 1
+#error "inc/font.h does not match the generated atlas, update FONT_N_COLUMNS, FONT_N_GLYPHS and FONT_N_EXTRAS"
+#endif
+
+const uint16_t font_columns[FONT_N_COLUMNS] = {
+    0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x077f, 0x077f, 0x073f, 0x000f, 0x000f, 0x0000, 0x0000,
+    0x000f, 0x0080, 0x0490, 0x07d0, 0x01f8, 0x00bf, 0x0791, 0x07f0, 0x00ff, 0x009f, 0x0090, 0x0010,
+    0x0238, 0x067c, 0x047e, 0x04f6, 0x1fff, 0x04e2, 0x07e2, 0x03c4, 0x000c, 0x001e, 0x0033, 0x0021,
+    0x063f, 0x039e, 0x01c0, 0x0070, 0x001c, 0x03ce, 0x07e3, 0x0421, 0x0660, 0x03c0, 0x0180, 0x01e0,
+    0x03f0, 0x07fe, 0x043f, 0x0479, 0x04f1, 0x07e1, 0x0782, 0x07e0, 0x07f0, 0x0470, 0x000f, 0x000f,
+    0x01f0, 0x07fc, 0x1fff, 0x1c07, 0x1001, 0x1c07, 0x1fff, 0x07fc, 0x00e0, 0x0036, 0x001c, 0x007f,
+    0x007f, 0x001c, 0x0036, 0x0060, 0x0060, 0x0060, 0x07fe, 0x07fe, 0x0060, 0x0060, 0x0060, 0x0060,
+    0x1f00, 0x1f00, 0x0700, 0x0060, 0x0060, 0x0060, 0x0060, 0x0700, 0x0700, 0x0700, 0x0c00, 0x0f80,
+    0x01f0, 0x003e, 0x0007, 0x01fc, 0x03fe, 0x07ff, 0x0401, 0x0401, 0x0603, 0x03fe, 0x03fe, 0x00f8,
+    0x0402, 0x0401, 0x07ff, 0x07ff, 0x07ff, 0x0400, 0x0400, 0x0402, 0x0701, 0x0781, 0x07c1, 0x05e3,
+    0x04ff, 0x047e, 0x041e, 0x0202, 0x0403, 0x0421, 0x0421, 0x0433, 0x07ff, 0x07ff, 0x03ce, 0x00e0,
+    0x00f8, 0x00bc, 0x008e, 0x07ff, 0x07ff, 0x07ff, 0x0080, 0x0080, 0x0200, 0x043f, 0x041f, 0x0411,
+    0x0411, 0x07f1, 0x03f1, 0x03e1, 0x01f8, 0x03fe, 0x07fe, 0x0633, 0x0411, 0x0631, 0x07f1, 0x03e2,
+    0x01c0, 0x0001, 0x0401, 0x0701, 0x07e1, 0x03f9, 0x00ff, 0x003f, 0x0007, 0x03ce, 0x07fe, 0x07ff,
+    0x0421, 0x0421, 0x067f, 0x07ff, 0x03de, 0x0100, 0x003e, 0x047e, 0x047f, 0x0441, 0x0641, 0x077f,
+    0x03fe, 0x01fc, 0x0020, 0x0738, 0x0738, 0x1800, 0x1f38, 0x0f38, 0x00e0, 0x00e0, 0x01f0, 0x01b0,
+    0x01b0, 0x0318, 0x0318, 0x071c, 0x060c, 0x0198, 0x0198, 0x0198, 0x0198, 0x0198, 0x0198, 0x0198,
+    0x0198, 0x0198, 0x060c, 0x0318, 0x0318, 0x0318, 0x01b0, 0x01b0, 0x00e0, 0x00e0, 0x00e0, 0x0002,
+    0x0701, 0x0771, 0x0779, 0x003f, 0x001f, 0x000e, 0x01f0, 0x07bc, 0x0c06, 0x08e2, 0x19f3, 0x1319,
+    0x1209, 0x1319, 0x13f9, 0x1bfa, 0x0306, 0x01fc, 0x00f0, 0x0400, 0x0780, 0x07f0, 0x01fe, 0x00ff,
+    0x008f, 0x009f, 0x00ff, 0x03f8, 0x07e0, 0x0700, 0x07ff, 0x07ff, 0x07ff, 0x0421, 0x0421, 0x0421,
+    0x07ff, 0x07ff, 0x03de, 0x01fc, 0x03fe, 0x03fe, 0x0603, 0x0401, 0x0401, 0x0401, 0x0401, 0x0603,
+    0x07ff, 0x07ff, 0x07ff, 0x0401, 0x0401, 0x0401, 0x0603, 0x078f, 0x03fe, 0x01fc, 0x0070, 0x07ff,
+    0x07ff, 0x07ff, 0x0421, 0x0421, 0x0421, 0x0421, 0x0421, 0x07ff, 0x07ff, 0x07ff, 0x0021, 0x0021,
+    0x0021, 0x0021, 0x0021, 0x01fc, 0x03fe, 0x03fe, 0x0603, 0x0401, 0x0401, 0x0421, 0x07e1, 0x07e3,
+    0x07e3, 0x07ff, 0x07ff, 0x07ff, 0x0020, 0x0020, 0x0020, 0x0020, 0x07ff, 0x07ff, 0x07ff, 0x07ff,
+    0x07ff, 0x07ff, 0x2000, 0x2000, 0x3fff, 0x3fff, 0x1fff, 0x07ff, 0x07ff, 0x07ff, 0x0078, 0x00f8,
+    0x01fc, 0x03ce, 0x0787, 0x0703, 0x0601, 0x0400, 0x07ff, 0x07ff, 0x07ff, 0x0400, 0x0400, 0x0400,
+    0x0400, 0x0400, 0x07ff, 0x07ff, 0x07ff, 0x000f, 0x007e, 0x01f0, 0x01e0, 0x01f8, 0x003e, 0x000f,
+    0x07ff, 0x07ff, 0x07ff, 0x07ff, 0x07ff, 0x07ff, 0x001f, 0x003c, 0x00f0, 0x03c0, 0x07ff, 0x07ff,
+    0x07ff, 0x01fc, 0x03fe, 0x03fe, 0x0603, 0x0401, 0x0401, 0x0401, 0x0707, 0x03fe, 0x03fe, 0x00f8,
+    0x07ff, 0x07ff, 0x07ff, 0x0041, 0x0041, 0x0041, 0x007f, 0x007f, 0x003e, 0x01fc, 0x03fe, 0x03fe,
+    0x0603, 0x0401, 0x0401, 0x0c01, 0x1f07, 0x1bfe, 0x13fe, 0x00f8, 0x07ff, 0x07ff, 0x07ff, 0x0041,
+    0x0041, 0x00e3, 0x03ff, 0x07be, 0x071c, 0x0600, 0x061c, 0x063e, 0x047f, 0x0471, 0x0471, 0x06f1,
+    0x07f1, 0x03e3, 0x01c0, 0x0001, 0x0001, 0x0001, 0x0001, 0x07ff, 0x07ff, 0x07ff, 0x0001, 0x0001,
+    0x0001, 0x01ff, 0x03ff, 0x07ff, 0x0600, 0x0400, 0x0400, 0x0600, 0x07ff, 0x03ff, 0x01ff, 0x0001,
+    0x000f, 0x007f, 0x03fe, 0x07f0, 0x0780, 0x07c0, 0x07f8, 0x00ff, 0x003f, 0x0007, 0x0001, 0x001f,
+    0x01ff, 0x07fe, 0x07e0, 0x07c0, 0x03fe, 0x003f, 0x000f, 0x00ff, 0x07f8, 0x0780, 0x07f8, 0x07ff,
+    0x007f, 0x0007, 0x0603, 0x0707, 0x07df, 0x01fc, 0x00f8, 0x00fc, 0x03fe, 0x078f, 0x0703, 0x0401,
+    0x0001, 0x0007, 0x000f, 0x003e, 0x07fc, 0x07f8, 0x07fc, 0x001e, 0x000f, 0x0003, 0x0001, 0x0701,
+    0x07c1, 0x07e1, 0x07f1, 0x04fd, 0x047f, 0x043f, 0x040f, 0x0407, 0x1fff, 0x1fff, 0x1fff, 0x1001,
+    0x1001, 0x0003, 0x001f, 0x00f8, 0x07c0, 0x0e00, 0x1001, 0x1001, 0x1fff, 0x1fff, 0x1fff, 0x0008,
+    0x000c, 0x0006, 0x0003, 0x0003, 0x0007, 0x000e, 0x000c, 0x0008, 0x4000, 0x4000, 0x4000, 0x4000,
+    0x4000, 0x4000, 0x4000, 0x4000, 0x0001, 0x0003, 0x0002, 0x0388, 0x07c8, 0x06c8, 0x0448, 0x0648,
+    0x07f8, 0x07f8, 0x07f0, 0x07ff, 0x07ff, 0x07ff, 0x0618, 0x0408, 0x0408, 0x07f8, 0x03f0, 0x01e0,
+    0x03f0, 0x03f0, 0x07f8, 0x0408, 0x0408, 0x0408, 0x0210, 0x03f0, 0x07f8, 0x07f8, 0x0408, 0x0408,
+    0x0210, 0x07ff, 0x07ff, 0x07ff, 0x03f0, 0x03f0, 0x0778, 0x0448, 0x0448, 0x0458, 0x0478, 0x0270,
+    0x0040, 0x0008, 0x0008, 0x07ff, 0x07ff, 0x0009, 0x0009, 0x0009, 0x03f0, 0x37f8, 0x27f8, 0x2408,
+    0x2408, 0x3610, 0x3ff8, 0x1ff8, 0x07f8, 0x07ff, 0x07ff, 0x07ff, 0x0010, 0x0008, 0x0018, 0x07f8,
+    0x07f8, 0x07e0, 0x07fb, 0x07fb, 0x07fb, 0x2000, 0x2000, 0x3ffb, 0x3ffb, 0x1ffb, 0x07ff, 0x07ff,
+    0x07ff, 0x00e0, 0x01f0, 0x03b8, 0x0718, 0x0608, 0x0400, 0x07ff, 0x07ff, 0x07ff, 0x07f8, 0x07f8,
+    0x07f8, 0x0010, 0x0008, 0x07f8, 0x07f8, 0x07f0, 0x0010, 0x0008, 0x0018, 0x07f8, 0x07f0, 0x07c0,
+    0x07f8, 0x07f8, 0x07f8, 0x0010, 0x0008, 0x0018, 0x07f8, 0x07f8, 0x07e0, 0x03f0, 0x03f0, 0x0738,
+    0x0408, 0x0408, 0x0618, 0x07f8, 0x03f0, 0x00c0, 0x3ff8, 0x3ff8, 0x3ff8, 0x0618, 0x0408, 0x0408,
+    0x07f8, 0x03f0, 0x01e0, 0x03f0, 0x07f8, 0x07f8, 0x0408, 0x0408, 0x0210, 0x3ff8, 0x3ff8, 0x3ff8,
+    0x07f8, 0x07f8, 0x07f8, 0x0010, 0x0008, 0x0008, 0x0270, 0x04f8, 0x04e8, 0x04c8, 0x07c8, 0x07d8,
+    0x0390, 0x0008, 0x01ff, 0x07ff, 0x07ff, 0x0408, 0x0408, 0x0408, 0x03f8, 0x07f8, 0x07f8, 0x0400,
+    0x0400, 0x0600, 0x07f8, 0x07f8, 0x0008, 0x0038, 0x01f8, 0x07e0, 0x0780, 0x0780, 0x07f0, 0x00f8,
+    0x0038, 0x0078, 0x07f8, 0x07f0, 0x0780, 0x07f0, 0x0078, 0x00f8, 0x07e0, 0x0780, 0x07f0, 0x03f8,
+    0x0038, 0x0618, 0x0738, 0x03f8, 0x01e0, 0x01f0, 0x07f8, 0x0718, 0x0408, 0x0008, 0x2038, 0x21f8,
+    0x37e0, 0x3f80, 0x1f80, 0x07f0, 0x01f8, 0x0038, 0x0708, 0x0788, 0x07c8, 0x05f8, 0x04f8, 0x0478,
+    0x0438, 0x0040, 0x0040, 0x1ffe, 0x3fff, 0x3f1f, 0x2001, 0x2001, 0x7fff, 0x7fff, 0x2001, 0x2001,
+    0x3fbf, 0x3fff, 0x0ffc, 0x0040, 0x0040, 0x00e0, 0x0060, 0x0060, 0x0060, 0x00e0, 0x00c0, 0x00c0,
+    0x00c0, 0x0060, 0x000e, 0x001f, 0x0011, 0x0011, 0x000e,
+};
+
+const font_glyph font_glyphs[FONT_N_GLYPHS] = {
+    {   0,  5},   // ' '
+    {   5,  3},   // '!'
+    {   8,  5},   // '"'
+    {  13, 11},   // '#'
+    {  24,  8},   // '$'
+    {  32, 15},   // '%'
+    {  47, 11},   // '&'
+    {  58,  2},   // "'"
+    {  60,  4},   // '('
+    {  64,  5},   // ')'
+    {  69,  6},   // '*'
+    {  75,  9},   // '+'
+    {  84,  3},   // ','
+    {  87,  4},   // '-'
+    {  91,  3},   // '.'
+    {  94,  5},   // '/'
+    {  99,  9},   // '0'
+    { 108,  7},   // '1'
+    { 115,  8},   // '2'
+    { 123,  8},   // '3'
+    { 131,  9},   // '4'
+    { 140,  8},   // '5'
+    { 148,  9},   // '6'
+    { 157,  8},   // '7'
+    { 165,  9},   // '8'
+    { 174,  9},   // '9'
+    { 183,  2},   // ':'
+    { 185,  3},   // ';'
+    { 188,  9},   // '<'
+    { 197,  9},   // '='
+    { 206,  9},   // '>'
+    { 215,  7},   // '?'
+    { 222, 13},   // '@'
+    { 235, 11},   // 'A'
+    { 246,  9},   // 'B'
+    { 255,  9},   // 'C'
+    { 264, 11},   // 'D'
+    { 275,  8},   // 'E'
+    { 283,  8},   // 'F'
+    { 291, 10},   // 'G'
+    { 301, 10},   // 'H'
+    { 311,  3},   // 'I'
+    { 314,  5},   // 'J'
+    { 319, 11},   // 'K'
+    { 330,  8},   // 'L'
+    { 338, 13},   // 'M'
+    { 351, 10},   // 'N'
+    { 361, 11},   // 'O'
+    { 372,  9},   // 'P'
+    { 381, 11},   // 'Q'
+    { 392, 10},   // 'R'
+    { 402,  9},   // 'S'
+    { 411, 10},   // 'T'
+    { 421, 10},   // 'U'
+    { 431, 11},   // 'V'
+    { 442, 16},   // 'W'
+    { 458, 10},   // 'X'
+    { 468, 11},   // 'Y'
+    { 479,  9},   // 'Z'
+    { 488,  5},   // '['
+    { 493,  5},   // '\\'
+    { 498,  5},   // ']'
+    { 503,  9},   // '^'
+    { 512,  8},   // '_'
+    { 520,  3},   // '`'
+    { 523,  8},   // 'a'
+    { 531,  9},   // 'b'
+    { 540,  7},   // 'c'
+    { 547,  9},   // 'd'
+    { 556,  9},   // 'e'
+    { 565,  7},   // 'f'
+    { 572,  9},   // 'g'
+    { 581,  9},   // 'h'
+    { 590,  3},   // 'i'
+    { 593,  5},   // 'j'
+    { 598,  9},   // 'k'
+    { 607,  3},   // 'l'
+    { 610, 14},   // 'm'
+    { 624,  9},   // 'n'
+    { 633,  9},   // 'o'
+    { 642,  9},   // 'p'
+    { 651,  9},   // 'q'
+    { 660,  6},   // 'r'
+    { 666,  7},   // 's'
+    { 673,  7},   // 't'
+    { 680,  8},   // 'u'
+    { 688,  9},   // 'v'
+    { 697, 12},   // 'w'
+    { 709,  8},   // 'x'
+    { 717,  9},   // 'y'
+    { 726,  7},   // 'z'
+    { 733,  7},   // '{'
+    { 740,  2},   // '|'
+    { 742,  7},   // '}'
+    { 749,  9},   // '~'
+    { 758,  5},   // '\xb0'
+};
+
+const uint8_t font_ascii[128] = {
+     31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,
+     31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,  31,
+      0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  10,  11,  12,  13,  14,  15,
+     16,  17,  18,  19,  20,  21,  22,  23,  24,  25,  26,  27,  28,  29,  30,  31,
+     32,  33,  34,  35,  36,  37,  38,  39,  40,  41,  42,  43,  44,  45,  46,  47,
+     48,  49,  50,  51,  52,  53,  54,  55,  56,  57,  58,  59,  60,  61,  62,  63,
+     64,  65,  66,  67,  68,  69,  70,  71,  72,  73,  74,  75,  76,  77,  78,  79,
+     80,  81,  82,  83,  84,  85,  86,  87,  88,  89,  90,  91,  92,  93,  94,  31,
+};
+
+const font_extra_glyph font_extras[FONT_N_EXTRAS] = {
+    {0x00b0,  95},   // U+00B0
+};
@@ -0,0 +1,58 @@
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "image.h"
+#include "neopixels.h"
+
+
+const image *image_find(const char *name)
+{
+    int i;
+
+    for (i = 0; i < n_images; i++) {
+        if (strcmp(images[i]->name, name) == 0)
+            return images[i];
+    }
+
+    return NULL;
+}
+
+
+int image_decoder_start(image_decoder *decoder, const image *img, int frame)
+{
+    const image_color *c;
+    int i;
+
+    if (frame < 0 || frame >= img->n_frames)
+        return -1;
+
+    // convert the palette once per frame rather than once per pixel
+    for (i = 0; i < img->n_colors; i++) {
+        c = &img->palette[i];
+        decoder->palette[i] = urgbw_u32(c->r, c->g, c->b, c->w);
+    }
+
+    decoder->image = img;
+    decoder->next = &img->data[img->frames[frame]];
+    decoder->run = 0;
+    decoder->color = 0;
+    return 0;
+}
+
+
+void image_decode_column(image_decoder *decoder, uint32_t *column)
+{
+    int i;
+    uint8_t code;
+
+    for (i = 0; i < decoder->image->height; i++) {
+        if (decoder->run == 0) {
+            code = *decoder->next++;
+            decoder->run = (code >> 4) + 1;
+            decoder->color = decoder->palette[code & 0x0f];
+        }
+        column[i] = decoder->color;
+        decoder->run--;
+    }
+}
@@ -0,0 +1,140 @@
+/*
+Generated by scripts/generate_image.py from heart.png, rainbow.gif
+Do not edit by hand, see inc/image.h for the format
+*/
+
+#include "image.h"
+
+static const image_color heart_palette[] = {
+    {255,   0,  40,   0},
+    {  0,   0,   0,   0},
+};
+
+static const uint32_t heart_frames[] = {
+         0,
+};
+
+static const uint8_t heart_data[] = {
+    0xf1, 0x21, 0x20, 0xa1, 0x40, 0x81, 0x60, 0x71, 0x80, 0x51, 0x90, 0x51, 0x90, 0x51, 0x90, 0x31,
+    0x90, 0x31, 0x90, 0x41, 0x80, 0x51, 0x60, 0x81, 0x40, 0xa1, 0x20, 0xf1, 0x61,
+};
+
+static const image heart_image = {
+    .name = "heart",
+    .width = 15,
+    .height = 15,
+    .n_frames = 1,
+    .n_colors = 2,
+    .palette = heart_palette,
+    .frames = heart_frames,
+    .data = heart_data,
+};
+
+static const image_color rainbow_palette[] = {
+    {187, 255,   0,   0},
+    { 55, 255,   0,   0},
+    {  0, 255, 219,   0},
+    {  0, 255, 147,   0},
+    {  0, 255,  63,   0},
+    {255, 203,   0,   0},
+    {255, 131,   0,   0},
+    {  0, 183, 255,   0},
+    {255,  59,   0,   0},
+    {  0,  63, 255,   0},
+    {253,   0, 225,   0},
+    {255,   0, 143,   0},
+    {255,   0,  47,   0},
+    {163,   0, 255,   0},
+    { 43,   0, 255,   0},
+    {  0,   0,   0,   0},
+};
+
+static const uint32_t rainbow_frames[] = {
+         0,    129,    257,    386,    514,    643,    771,    900,
+};
+
+static const uint8_t rainbow_data[] = {
+    0x4f, 0x4c, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0x9f, 0x46, 0xaf, 0x46, 0x9f, 0x45,
+    0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x8f, 0x45, 0x9f, 0x40, 0x8f, 0x40, 0x8f, 0x40, 0x8f, 0x40,
+    0x8f, 0x40, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x9f, 0x41, 0x8f, 0x44, 0x9f, 0x44,
+    0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x43, 0xaf, 0x43, 0x9f, 0x43, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x42,
+    0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x47, 0xaf, 0x47, 0xaf, 0x47, 0x9f, 0x47, 0xaf, 0x49, 0x9f, 0x49,
+    0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x4e, 0x8f, 0x4e, 0x9f, 0x4e, 0x8f, 0x4e, 0x8f, 0x4e, 0x8f, 0x4d,
+    0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4a, 0x9f, 0x4a, 0x8f, 0x4a, 0x9f, 0x4a,
+    0x9f, 0x4a, 0x9f, 0x4b, 0x9f, 0x4b, 0xaf, 0x4b, 0x9f, 0x4c, 0xaf, 0x4c, 0xaf, 0x4c, 0xaf, 0x4c,
+    0x5f, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x8f, 0x45, 0x9f, 0x40, 0x8f, 0x40, 0x8f, 0x40, 0x8f,
+    0x40, 0x8f, 0x40, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x9f, 0x41, 0x8f, 0x44, 0x9f,
+    0x44, 0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x43, 0xaf, 0x43, 0x9f, 0x43, 0xaf, 0x42, 0xaf, 0x42, 0xaf,
+    0x42, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x47, 0xaf, 0x47, 0xaf, 0x47, 0x9f, 0x47, 0xaf, 0x49, 0x9f,
+    0x49, 0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x4e, 0x8f, 0x4e, 0x9f, 0x4e, 0x8f, 0x4e, 0x8f, 0x4e, 0x8f,
+    0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4a, 0x9f, 0x4a, 0x8f, 0x4a, 0x9f,
+    0x4a, 0x9f, 0x4a, 0x9f, 0x4b, 0x9f, 0x4b, 0xaf, 0x4b, 0x9f, 0x4c, 0xaf, 0x4c, 0xaf, 0x4c, 0xaf,
+    0x4c, 0xaf, 0x4c, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0x9f, 0x46, 0xaf, 0x46, 0x9f,
+    0x45, 0x4f, 0x40, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x9f, 0x41, 0x8f, 0x44, 0x9f,
+    0x44, 0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x43, 0xaf, 0x43, 0x9f, 0x43, 0xaf, 0x42, 0xaf, 0x42, 0xaf,
+    0x42, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x47, 0xaf, 0x47, 0xaf, 0x47, 0x9f, 0x47, 0xaf, 0x49, 0x9f,
+    0x49, 0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x4e, 0x8f, 0x4e, 0x9f, 0x4e, 0x8f, 0x4e, 0x8f, 0x4e, 0x8f,
+    0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4a, 0x9f, 0x4a, 0x8f, 0x4a, 0x9f,
+    0x4a, 0x9f, 0x4a, 0x9f, 0x4b, 0x9f, 0x4b, 0xaf, 0x4b, 0x9f, 0x4c, 0xaf, 0x4c, 0xaf, 0x4c, 0xaf,
+    0x4c, 0xaf, 0x4c, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0x9f, 0x46, 0xaf, 0x46, 0x9f,
+    0x45, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x8f, 0x45, 0x9f, 0x40, 0x8f, 0x40, 0x8f, 0x40, 0x8f,
+    0x40, 0x3f, 0x44, 0x9f, 0x44, 0x9f, 0x43, 0xaf, 0x43, 0x9f, 0x43, 0xaf, 0x42, 0xaf, 0x42, 0xaf,
+    0x42, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x47, 0xaf, 0x47, 0xaf, 0x47, 0x9f, 0x47, 0xaf, 0x49, 0x9f,
+    0x49, 0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x4e, 0x8f, 0x4e, 0x9f, 0x4e, 0x8f, 0x4e, 0x8f, 0x4e, 0x8f,
+    0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4a, 0x9f, 0x4a, 0x8f, 0x4a, 0x9f,
+    0x4a, 0x9f, 0x4a, 0x9f, 0x4b, 0x9f, 0x4b, 0xaf, 0x4b, 0x9f, 0x4c, 0xaf, 0x4c, 0xaf, 0x4c, 0xaf,
+    0x4c, 0xaf, 0x4c, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0x9f, 0x46, 0xaf, 0x46, 0x9f,
+    0x45, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x8f, 0x45, 0x9f, 0x40, 0x8f, 0x40, 0x8f, 0x40, 0x8f,
+    0x40, 0x8f, 0x40, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x9f, 0x41, 0x8f, 0x44, 0x9f,
+    0x44, 0x9f, 0x4f, 0x42, 0xaf, 0x42, 0xaf, 0x47, 0xaf, 0x47, 0xaf, 0x47, 0x9f, 0x47, 0xaf, 0x49,
+    0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x4e, 0x8f, 0x4e, 0x9f, 0x4e, 0x8f, 0x4e, 0x8f, 0x4e,
+    0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4a, 0x9f, 0x4a, 0x8f, 0x4a,
+    0x9f, 0x4a, 0x9f, 0x4a, 0x9f, 0x4b, 0x9f, 0x4b, 0xaf, 0x4b, 0x9f, 0x4c, 0xaf, 0x4c, 0xaf, 0x4c,
+    0xaf, 0x4c, 0xaf, 0x4c, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0x9f, 0x46, 0xaf, 0x46,
+    0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x8f, 0x45, 0x9f, 0x40, 0x8f, 0x40, 0x8f, 0x40,
+    0x8f, 0x40, 0x8f, 0x40, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x9f, 0x41, 0x8f, 0x44,
+    0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x43, 0xaf, 0x43, 0x9f, 0x43, 0xaf, 0x42, 0xaf, 0x42,
+    0xaf, 0x42, 0x5f, 0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x4e, 0x8f, 0x4e, 0x9f, 0x4e, 0x8f, 0x4e, 0x8f,
+    0x4e, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4a, 0x9f, 0x4a, 0x8f,
+    0x4a, 0x9f, 0x4a, 0x9f, 0x4a, 0x9f, 0x4b, 0x9f, 0x4b, 0xaf, 0x4b, 0x9f, 0x4c, 0xaf, 0x4c, 0xaf,
+    0x4c, 0xaf, 0x4c, 0xaf, 0x4c, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0x9f, 0x46, 0xaf,
+    0x46, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x8f, 0x45, 0x9f, 0x40, 0x8f, 0x40, 0x8f,
+    0x40, 0x8f, 0x40, 0x8f, 0x40, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x9f, 0x41, 0x8f,
+    0x44, 0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x43, 0xaf, 0x43, 0x9f, 0x43, 0xaf, 0x42, 0xaf,
+    0x42, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x47, 0xaf, 0x47, 0xaf, 0x47, 0x9f, 0x47, 0xaf,
+    0x49, 0x9f, 0x49, 0x4f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4a, 0x9f, 0x4a, 0x8f,
+    0x4a, 0x9f, 0x4a, 0x9f, 0x4a, 0x9f, 0x4b, 0x9f, 0x4b, 0xaf, 0x4b, 0x9f, 0x4c, 0xaf, 0x4c, 0xaf,
+    0x4c, 0xaf, 0x4c, 0xaf, 0x4c, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0x9f, 0x46, 0xaf,
+    0x46, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x8f, 0x45, 0x9f, 0x40, 0x8f, 0x40, 0x8f,
+    0x40, 0x8f, 0x40, 0x8f, 0x40, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x9f, 0x41, 0x8f,
+    0x44, 0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x43, 0xaf, 0x43, 0x9f, 0x43, 0xaf, 0x42, 0xaf,
+    0x42, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x47, 0xaf, 0x47, 0xaf, 0x47, 0x9f, 0x47, 0xaf,
+    0x49, 0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x4e, 0x8f, 0x4e, 0x9f, 0x4e, 0x8f, 0x4e, 0x8f,
+    0x4e, 0x8f, 0x4d, 0x3f, 0x4a, 0x9f, 0x4b, 0x9f, 0x4b, 0xaf, 0x4b, 0x9f, 0x4c, 0xaf, 0x4c, 0xaf,
+    0x4c, 0xaf, 0x4c, 0xaf, 0x4c, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0xaf, 0x48, 0x9f, 0x46, 0xaf,
+    0x46, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x9f, 0x45, 0x8f, 0x45, 0x9f, 0x40, 0x8f, 0x40, 0x8f,
+    0x40, 0x8f, 0x40, 0x8f, 0x40, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x8f, 0x41, 0x9f, 0x41, 0x8f,
+    0x44, 0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x44, 0x9f, 0x43, 0xaf, 0x43, 0x9f, 0x43, 0xaf, 0x42, 0xaf,
+    0x42, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x42, 0xaf, 0x47, 0xaf, 0x47, 0xaf, 0x47, 0x9f, 0x47, 0xaf,
+    0x49, 0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x49, 0x9f, 0x4e, 0x8f, 0x4e, 0x9f, 0x4e, 0x8f, 0x4e, 0x8f,
+    0x4e, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4d, 0x8f, 0x4a, 0x9f, 0x4a, 0x8f,
+    0x4a, 0x9f, 0x4a, 0x9f,
+};
+
+static const image rainbow_image = {
+    .name = "rainbow",
+    .width = 64,
+    .height = 15,
+    .n_frames = 8,
+    .n_colors = 16,
+    .palette = rainbow_palette,
+    .frames = rainbow_frames,
+    .data = rainbow_data,
+};
+
+const image *const images[] = {
+    &heart_image,
+    &rainbow_image,
+};
+
+const int n_images = 2;
@@ -8,11 +8,21 @@ Main C file for the light wand project
 #include "pico/stdlib.h"
 #include "hardware/gpio.h"
 #include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/sync.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "hardware/pll.h"
+#include "hardware/xosc.h"
 #include "pico/multicore.h"
+#include "pico/stdio_usb.h"
 
 #include "neopixels.h"
 #include "ADXL343.h"
-#include "alphabet.h"
+#include "sampler.h"
+#include "pov.h"
+#include "commands.h"
+#include "trace.h"
 
 // misc defines
 #define BUTTON_DEBOUNCE_TIME_US     1000
@@ -23,29 +33,49 @@ Main C file for the light wand project
 #define BUTTON_PIN      28
 #define ADX_SDA_PIN     16
 #define ADX_SCL_PIN     17
-
-// defines relating to wand position
-#define ACCEL_MAX_MSS               30
-#define DIR_HYSTERESIS_MASK   0x00ffffff
-
-// defines relating to text display
-#define PIXEL_CHAR_COLOR        urgbw_u32(0, 0, 255, 128)
-#define PIXEL_BG_COLOR          urgbw_u32(0, 0, 0, 0)   
-#define PIXEL_REST_COLOR        urgbw_u32(0, 0, 0, 0)
-
-// choose the message to display on the wand
-// the message will be centered in the columns, and scaled as well
-#define MESSAGE_LEN             3
-#define MESSAGE_CHAR_SCALE      2   // 2 to double the width of the characters
-#define N_DISPLAY_COLUMNS       200
-const uint32_t *message[MESSAGE_LEN] = {CHAR_E, CHAR_C, CHAR_E};
+#define ADX_INT1_PIN    18
+
+// the accelerometer's INT1 isn't connected to ADX_INT1_PIN on the board as built, so its FIFO is polled for batches.
+// -DADX_INT1_WIRED=1 for a board with the wire added (see hardware/Readme.md), which reads each batch as it fills
+#ifndef ADX_INT1_WIRED
+#define ADX_INT1_WIRED  0
+#endif
+
+// the accelerometer is on i2c as built. -DADX_USE_SPI=1 for one wired for 4-wire SPI on spi0 instead
+#ifndef ADX_USE_SPI
+#define ADX_USE_SPI     0
+#endif
+#define ADX_SCK_PIN     22
+#define ADX_MOSI_PIN    19
+#define ADX_MISO_PIN    16
+#define ADX_CS_PIN      17
+
+// idle mode. After ADX_IDLE_TIME_S seconds of the wand lying still (0 for never), the strip is turned off, the
+// accelerometer only watches for the wand moving again, and both cores sleep. Thresholds are in units of 62.5mg
+#ifndef ADX_IDLE_TIME_S
+#define ADX_IDLE_TIME_S         10
+#endif
+#define ADX_INACTIVITY_THRESH   3       // 0.19g
+#define ADX_ACTIVITY_THRESH     8       // 0.5g, a swing is several g
+#define ADX_IDLE_DATA_RATE      (ADXL3XX_DATARATE_12_5_HZ | ADXL3XX_LOW_POWER)
+// without INT1 to wake on, INT_SOURCE is read this often for the wand moving. The idle data rate samples every 80ms
+#define ADX_IDLE_POLL_US        100000
+
+// with INT1 wired to wake it, and no USB host to stay connected to, the idle wand goes dormant with every clock
+// stopped, rather than just sleeping the cores
+#ifndef POV_IDLE_DORMANT
+#define POV_IDLE_DORMANT        1
+#endif
 
 // function prototypes
 void core1_main(void);
 void core1_sio_irq(void);
-void signal_dirchange(uint64_t swing_time, uint64_t dir_hist);
-int build_columns(const uint32_t **message, int m_len, uint32_t *columns, int n_cols, int scale);
+void core1_wake(void *param);
+void core1_set_idle(bool idle);
 void gpio_callback(uint gpio, uint32_t events);
+int adx_stream(adxl343 *accelerometer);
+void idle(adxl343 *accelerometer);
+void dormant_until_activity(void);
 
 // display state
 enum State {
@@ -55,9 +85,13 @@ enum State {
 // volatile global state so that GPIO interrupts can change the state
 volatile enum State current_state;
 
+// core 0 asks core 1 to go idle and back, and core 1 says when it has
+volatile bool idle_requested;
+volatile bool core1_idle;
+
 // Core 0 main handles wand position calculations
 int main() {
-    int i, err;
+    int err;
 
     stdio_init_all();
 
@@ -74,15 +108,28 @@ int main() {
     printf("Starting...\n");
     // initialize the accelerometer
     adxl343 accelerometer;
-    err = adxl343_setup(&accelerometer, i2c0, ADX_SDA_PIN, ADX_SCL_PIN, ADXL343_DEFAULT_ADDRESS);
+#if ADX_USE_SPI
+    err = adxl343_setup_spi(&accelerometer, spi0, ADX_SCK_PIN, ADX_MOSI_PIN, ADX_MISO_PIN, ADX_CS_PIN, ADXL343_SPI_MAX_HZ);
+#else
+    err = adxl343_setup(&accelerometer, i2c0, ADX_SDA_PIN, ADX_SCL_PIN, ADXL343_DEFAULT_ADDRESS, ADXL343_I2C_FAST_MODE_HZ);
+#endif
     if (err < 0) {
         printf("ADXL343 Setup failed... error %d\n", err);
     }
     printf("Accelerometer setup complete...\n");  
 
+    // stream samples into the FIFO, and have INT1 signal each full batch, and the wand lying still. The sampler reads
+    // INT_SOURCE with every batch, so the wand lying still is noticed whether INT1 is wired or not
+    err = adxl343_set_activity(&accelerometer, ADX_ACTIVITY_THRESH, ADX_INACTIVITY_THRESH, ADX_IDLE_TIME_S);
+    if (err >= 0)
+        err = adx_stream(&accelerometer);
+    if (err < 0) {
+        printf("ADXL343 interrupt setup failed... error %d\n", err);
+    }
+
     // initialize the LED strip
     setup_ws2812();
-    put_15_pixels_on_rgbw(urgbw_u32(0, 255, 0, 128));
+    put_pixels_on(urgbw_u32(0, 255, 0, 128));
     printf("LED's lit green\n");
 
     // set up the pushbutton
@@ -90,90 +137,76 @@ int main() {
     gpio_set_irq_enabled_with_callback(BUTTON_PIN, GPIO_IRQ_EDGE_RISE, true, &gpio_callback);
     gpio_pull_down(BUTTON_PIN);
 
+    // set up the accelerometer watermark interrupt, which hands each batch to the sampler to read off the bus in
+    // the background. Shares the gpio callback with the pushbutton. Without it, the sampler polls for batches
+#if ADX_INT1_WIRED
+    gpio_init(ADX_INT1_PIN);
+    gpio_set_dir(ADX_INT1_PIN, GPIO_IN);
+    err = sampler_init(&accelerometer, ADX_INT1_PIN, ADX_FIFO_WATERMARK, ADX_SAMPLE_PERIOD_US);
+    gpio_set_irq_enabled(ADX_INT1_PIN, GPIO_IRQ_EDGE_RISE, true);
+#else
+    err = sampler_init(&accelerometer, SAMPLER_NO_PIN, ADX_FIFO_WATERMARK, ADX_SAMPLE_PERIOD_US);
+#endif
+    if (err < 0) {
+        printf("Sampler setup failed... error %d\n", err);
+    }
+
     // Launch the second core
     multicore_launch_core1(core1_main);
 
     // variables relating to wand position
-    int16_t ax_raw;
-    float accel_mss = 0;
-    float prev_accel_mss = 0;
-    float jerk_msss = 0;
-    uint64_t prev_dir_change_time = 0;
-    uint64_t prev_swing_time_length = 0;
-    uint64_t prev_frame_time = 0;
-    uint64_t hidden_dir_hist = 0;  // lsb is current hidden direction
-    uint64_t diplay_dir_hist = 0;  // lsb is current display direction.
+    sampler_entry sample;
+    int16_t ax_raw = 0;
+    // the detector keeps the latest samples, which don't fit on the stack
+    static pov_detector detector;
+    pov_detector_init(&detector);
 
     // variables relating to rand mode
     uint64_t prev_rand_update_us = 0;
 
     while(1) {   
-        uint64_t now = time_us_64();
-
-        // update raw adx reading
-        adxl343_getx(&accelerometer, &ax_raw);
+        uint64_t now;
+
+        // sleep until the sampler has read a batch off the bus. It wakes the core up as it pushes the samples. The
+        // random display is updated on its own time, however often batches come
+        while (!sampler_available()) {
+            if (current_state != RANDOM)
+                __wfe();
+            else if (best_effort_wfe_or_timeout(from_us_since_boot(prev_rand_update_us + RAND_UPDATE_TIME_US)))
+                break;
+        }
+        now = time_us_64();
+
+        // update the wand direction one sample at a time, signalling core1 if it changed. The sampler reads the
+        // next batch in the meantime
+        while (sampler_pop(&sample)) {
+            ax_raw = sample.xyz.x;
+            if (current_state == POV)
+                pov_update_direction(&detector, sample.t_us, ax_raw);
+        }
+        pov_fit_profile(&detector);
+
+        // the accelerometer saw the wand lie still for ADX_IDLE_TIME_S. Sleep until it moves, and start detecting swings
+        // afresh, as the one before the rest has long ended
+        if (sampler_int_source() & ADXL3XX_INT_INACTIVITY) {
+            idle(&accelerometer);
+            pov_detector_init(&detector);
+            continue;
+        }
 
         // Logic for POV effect
         if (current_state == POV)
         {
             gpio_put(LED_PIN, 0);
 
-            // convert to acceleration in meters/s^2
-            accel_mss = (float)ax_raw * ADXL3XXVAL_TO_MSS;
-
-            // calculate the jerk of the wand in meters/s^3
-            jerk_msss = (accel_mss - prev_accel_mss) / ((float)(now - prev_frame_time) / 1000000.0f);
-            
-            // caculate the direction of the wand based on jerk
-            if (jerk_msss < 0) {
-                // if jerk is negative, wand is moving 'left' (0)
-                hidden_dir_hist = (hidden_dir_hist << 1) | 0;
-            }
-            else if (jerk_msss > 0) {
-                // if jerk is positive, wand is moving 'right' (1)
-                hidden_dir_hist = (hidden_dir_hist << 1) | 1;
-            }
-            else {
-                // otherwise, assume wand is continuing in the same direction
-                i = hidden_dir_hist & 1;
-                hidden_dir_hist = (hidden_dir_hist << 1) | i;
-            }
-
-            // update the displayed direction based on the hidden direction, using hysteresis.
-            if (((hidden_dir_hist & DIR_HYSTERESIS_MASK) == 0) && ((diplay_dir_hist & 1) == 1)) {
-                // all previous hidden directions in DIR_HYSTERESIS_MASK were '0' - set display direction to 0
-                diplay_dir_hist = (diplay_dir_hist << 1) | 0;
-
-                // the direction of the wand has changed - update the amount of time the swing that just ended took
-                prev_swing_time_length = now - prev_dir_change_time;
-                prev_dir_change_time = now;
-
-                signal_dirchange(prev_swing_time_length, diplay_dir_hist);
-            }
-            else if (((hidden_dir_hist & DIR_HYSTERESIS_MASK) == DIR_HYSTERESIS_MASK) && ((diplay_dir_hist & 1) == 0)) {
-                // all previous hidden directions in DIR_HYSTERESIS_MASK were '1' - set display direction to 1
-                diplay_dir_hist = (diplay_dir_hist << 1) | 1;
-
-                // the direction of the wand has changed - update the amount of time the swing that just ended took
-                prev_swing_time_length = now - prev_dir_change_time;
-                prev_dir_change_time = now;
-
-                signal_dirchange(prev_swing_time_length, diplay_dir_hist);
-            }
-            else {
-                // If there is no cause to change the display direction, just set it to the previous direction
-                i = diplay_dir_hist & 1;
-                diplay_dir_hist = (diplay_dir_hist << 1) | i;
-            }
-
-            prev_accel_mss = accel_mss;
-            prev_frame_time = now;
+            // the next batch comes too late for a reversal due before it, so start that swing now
+            pov_anticipate_reversal(&detector, now);
         }
         // Logic for random display
         else if (current_state == RANDOM) {
             gpio_put(LED_PIN, 1);
-            if (prev_rand_update_us + RAND_UPDATE_TIME_US < now) {
-                put_15_random_rgbw(abs(ax_raw));
+            if (prev_rand_update_us + RAND_UPDATE_TIME_US <= now) {
+                put_random(abs(ax_raw));
                 prev_rand_update_us = time_us_64();
             }
         } 
@@ -186,102 +219,187 @@ int main() {
 // core1_main handles displaying on the LED strip
 void core1_main(void)
 {
-    uint32_t fifo_val;
-    uint64_t col_display_time, prev_swing_length, render_time;
-    int dir, i;
+    int i;
 
     printf("Launched core1\n");
 
-    // set up the columns
-    uint32_t *columns = (uint32_t *)malloc(N_DISPLAY_COLUMNS * sizeof(uint32_t));
-    i = build_columns(message, MESSAGE_LEN, columns, N_DISPLAY_COLUMNS, MESSAGE_CHAR_SCALE);
+    // render the default message into the framebuffer shown from the first swing on
+    // the renderer holds a column mask per display column, which is too much for core 1's small stack
+    static pov_renderer renderer;
+    command_reader commands;
+    const char *line;
+
+    i = pov_renderer_start(&renderer, POV_DEFAULT_TEXT, MESSAGE_CHAR_SCALE, POV_DEFAULT_SCROLL, PIXEL_CHAR_COLOR,
+                           PIXEL_BG_COLOR);
     if (i < 0) {
         printf("Failed to build the columns\n");
         return;
     }
+    while (pov_renderer_step(&renderer))
+        ;
+    command_reader_init(&commands);
 
-    while (1) {
-        // wait for something to appear on the fifo
-        while (!multicore_fifo_rvalid())
-            tight_loop_contents();
+    // the column alarm has to fire on this core
+    pov_display_init();
+    setup_ws2812_dma();
 
-        // now that something is on the fifo, pop it all off
-        while (multicore_fifo_rvalid())
-            fifo_val = multicore_fifo_pop_blocking();
+    // swings are started from the FIFO interrupt, and the columns are released by the alarm interrupt, so swings
+    // always come first. The interrupts share a priority so that neither can cut into the other
+    multicore_fifo_clear_irq();
+    irq_set_exclusive_handler(SIO_IRQ_PROC1, core1_sio_irq);
+    irq_set_enabled(SIO_IRQ_PROC1, true);
 
-        // extract the prev swing length from the fifo value
-        prev_swing_length = (uint64_t)(fifo_val & ~(1 << 31));
+    // USB input arrives on core 0, which wakes this core up for it
+    stdio_set_chars_available_callback(core1_wake, NULL);
 
-        // extract the current direction from the fifo value
-        dir = (int)(fifo_val >> 31);
+    while (1) {
+        if (core1_idle != idle_requested)
+            core1_set_idle(idle_requested);
+
+        // commands and rendering happen in the time between interrupts, a column at a time. With nothing left to do,
+        // sleep until an interrupt or core 0 wakes the core up again
+        if ((line = command_poll(&commands)) != NULL)
+            command_execute(line, &renderer);
+        else if (!pov_renderer_step(&renderer))
+            __wfe();
+    }
 
-        // calculate the amount of time in us each column should be displayed
-        col_display_time = prev_swing_length / N_DISPLAY_COLUMNS;
+    return;
+}
 
-        // now, loop for the duration of the swing, in the proper direction 
-        for (i = 0; i < N_DISPLAY_COLUMNS; i++) {
-            // If something new shows up on the FIFO, finish the swing
-            if (multicore_fifo_rvalid()) {
-                break;
-            }
+// core 0 rang the doorbell: start displaying the newest swing
+void core1_sio_irq(void)
+{
+    pov_start_next_swing();
 
-            // index in the proper direction
-            if (dir == 0)
-                render_time = put_15_pixels_rgbw(columns[N_DISPLAY_COLUMNS-i-1], PIXEL_CHAR_COLOR, PIXEL_BG_COLOR);
-            else
-                render_time = put_15_pixels_rgbw(columns[i], PIXEL_CHAR_COLOR, PIXEL_BG_COLOR);
+    // also clears the FIFO's overflow and underflow flags, which would otherwise hold the interrupt up
+    multicore_fifo_clear_irq();
+}
 
-            // sleep the remaining amount of column time
-            sleep_us(col_display_time - render_time);
-        }
+// called on core 0 when USB input arrives
+void core1_wake(void *param)
+{
+    (void)param;
+    __sev();
+}
 
-        // printf("finished %d/%d\n", i, N_DISPLAY_COLUMNS);
+// going idle, no more swings are started and the strip is turned off. Commands are still taken
+void core1_set_idle(bool idle)
+{
+    if (idle) {
+        irq_set_enabled(SIO_IRQ_PROC1, false);
+        ws2812_dma_blank();
+    }
+    else {
+        // doorbells rung before core 0 went idle are long out of date
+        multicore_fifo_drain();
+        multicore_fifo_clear_irq();
+        irq_set_enabled(SIO_IRQ_PROC1, true);
     }
 
-    free(columns);
-    return;
+    // core 0 waits for this before it sleeps
+    core1_idle = idle;
+    __sev();
 }
 
-
-// Sends a message to Core 1 that starts displaying the next cycle
-void signal_dirchange(uint64_t swing_time, uint64_t dir_hist)
+// has the accelerometer stream batches into its FIFO at the full rate, signalling each one and inactivity on INT1
+int adx_stream(adxl343 *accelerometer)
 {
-    // printf("%f\t\n", swing_time / 1000000.0f);
-
-    // tell core1 to start displaying a new swing. Send 31 bits of prev_swing_time_length,
-    // with the MSB of the transferred 32 bit value being the direction of the wand.
-    // 31 bits of prev_swing_time_length corresponds to 2^31 * 10^-6 = 2.1k seconds maximum swing time
-    // In other words, as long as the user completes their swing in under half an hour, there should be no issues.
-    multicore_fifo_push_blocking((uint32_t)(swing_time | (dir_hist << 31)));
+    int err;
+    uint8_t source;
+
+    err = adxl343_set_interrupts(accelerometer, 0, 0);
+    if (err >= 0)
+        err = adxl343_set_data_rate(accelerometer, ADX_DATA_RATE);
+    if (err >= 0)
+        err = adxl343_set_fifo(accelerometer, ADXL3XX_FIFO_MODE_STREAM, ADX_FIFO_WATERMARK);
+    // an activity or inactivity left over from before would hold INT1 up
+    if (err >= 0)
+        err = adxl343_get_int_source(accelerometer, &source);
+    if (err >= 0)
+        err = adxl343_set_interrupts(accelerometer, ADXL3XX_INT_WATERMARK | (ADX_IDLE_TIME_S > 0 ? ADXL3XX_INT_INACTIVITY : 0), 0);
+    return err;
 }
 
-
-/*
-Converts the message (an array of arrays representing characters) into a 1-D array of column data
-The message is centered in the columns, and scaled by 'scale'
-Returns -1 on failure
-*/
-int build_columns(const uint32_t **message, int m_len, uint32_t *columns, int n_cols, int scale)
+// turns the strip off and sleeps until the accelerometer sees the wand move, then goes back to streaming samples
+void idle(adxl343 *accelerometer)
 {
-    int i, j;
-    int m_col_width = m_len * CHAR_WIDTH;
-
-    // check that the message will fit
-    if (n_cols < m_col_width * scale) 
-        return -1;
+    uint64_t start_us = time_us_64();
+    uint8_t source;
+    int err;
+
+    // the accelerometer is reconfigured over the bus, and core 1 has to let go of the strip first
+    sampler_stop();
+    idle_requested = true;
+    __sev();
+    while (!core1_idle)
+        __wfe();
+    gpio_put(LED_PIN, 0);
+    TRACE(TRACE_IDLE, 1, 0);
+
+    // sample slowly in low power mode, only to notice the wand moving
+    err = adxl343_set_interrupts(accelerometer, 0, 0);
+    if (err >= 0)
+        err = adxl343_set_fifo(accelerometer, ADXL3XX_FIFO_MODE_BYPASS, 0);
+    if (err >= 0)
+        err = adxl343_set_data_rate(accelerometer, ADX_IDLE_DATA_RATE);
+    if (err >= 0)
+        err = adxl343_get_int_source(accelerometer, &source);
+    if (err >= 0)
+        err = adxl343_set_interrupts(accelerometer, ADXL3XX_INT_ACTIVITY, 0);
 
-    j = 0;
-    for (i = 0; i < n_cols; i++) {
-        columns[i] = 0;
+    if (err < 0) {
+        printf("ADXL343 idle setup failed... error %d\n", err);
+    }
+    else {
+#if ADX_INT1_WIRED
+#if POV_IDLE_DORMANT
+        // USB doesn't survive the clocks stopping
+        if (!stdio_usb_connected())
+            dormant_until_activity();
+#endif
+        // ACTIVITY holds INT1 up until INT_SOURCE is read, so there's no edge to miss
+        while (!gpio_get(ADX_INT1_PIN))
+            __wfe();
+#else
+        // ask the accelerometer now and then whether it has seen the wand move, sleeping in between. A bus error
+        // wakes the wand up rather than leaving it asleep for good
+        while ((err = adxl343_get_int_source(accelerometer, &source)) >= 0 && !(source & ADXL3XX_INT_ACTIVITY))
+            sleep_us(ADX_IDLE_POLL_US);
+#endif
+    }
 
-        // only write the characters to the columns when near the center
-        if ((i >= n_cols/2 - ((m_col_width / 2) * scale)) && (i <= n_cols/2 + ((m_col_width / 2) * scale))) {
-            columns[i] = message[(j / scale) / CHAR_WIDTH][(j / scale) % CHAR_WIDTH]; 
-            j++;
-        }
+    err = adx_stream(accelerometer);
+    if (err < 0) {
+        printf("ADXL343 interrupt setup failed... error %d\n", err);
     }
+    sampler_start();
+    idle_requested = false;
+    __sev();
+    TRACE(TRACE_IDLE, 0, (uint32_t)((time_us_64() - start_us) / 1000));
+}
 
-    return 0;
+// stops the crystal, and with it every clock, until INT1 goes high, so only for a board with INT1 wired. Every clock
+// is moved onto the crystal or stopped first, so both PLLs can be turned off, and clocks_init brings them all back up
+// as they were at boot, which is what the firmware runs at. The timer stops too, so time spent dormant doesn't count
+void dormant_until_activity(void)
+{
+    uint32_t xosc_hz = XOSC_MHZ * MHZ;
+
+    clock_configure(clk_ref, CLOCKS_CLK_REF_CTRL_SRC_VALUE_XOSC_CLKSRC, 0, xosc_hz, xosc_hz);
+    clock_configure(clk_sys, CLOCKS_CLK_SYS_CTRL_SRC_VALUE_CLK_REF, 0, xosc_hz, xosc_hz);
+    clock_stop(clk_usb);
+    clock_stop(clk_adc);
+    clock_configure(clk_rtc, 0, CLOCKS_CLK_RTC_CTRL_AUXSRC_VALUE_XOSC_CLKSRC, xosc_hz, 46875);
+    clock_configure(clk_peri, 0, CLOCKS_CLK_PERI_CTRL_AUXSRC_VALUE_CLK_SYS, xosc_hz, xosc_hz);
+    pll_deinit(pll_sys);
+    pll_deinit(pll_usb);
+
+    gpio_set_dormant_irq_enabled(ADX_INT1_PIN, GPIO_IRQ_LEVEL_HIGH, true);
+    xosc_dormant();
+    gpio_set_dormant_irq_enabled(ADX_INT1_PIN, GPIO_IRQ_LEVEL_HIGH, false);
+
+    clocks_init();
 }
 
 void gpio_callback(uint gpio, uint32_t events) {
@@ -290,4 +408,9 @@ void gpio_callback(uint gpio, uint32_t events) {
         current_state = (current_state + 1) % (RANDOM + 1);
         last_pressed_us = time_us_64();
     }
+#if ADX_INT1_WIRED
+    else if (gpio == ADX_INT1_PIN) {
+        sampler_watermark();
+    }
+#endif
 }
\ No newline at end of file
@@ -1,7 +1,8 @@
 #include "neopixels.h"
+#include "trace.h"
 
 
-#define TX_PIN  0   // TX is hooked up to GPIO0
+#define TX_PIN  0   // TX is hooked up to GPIO0, further strips to the pins after it
 
 
 void setup_ws2812() 
@@ -9,7 +10,281 @@ void setup_ws2812()
     // setup code pulled from https://github.com/hutscape/hutscape.github.io/blob/master/_tutorials/code/pico-neopixel/pico-neopixel.c
     PIO pio = pio0;
     int sm = 0;
+#if WS2812_N_STRIPS > 1
+    uint offset = pio_add_program(pio, &ws2812_parallel_program);
+
+    ws2812_parallel_program_init(pio, sm, offset, TX_PIN, WS2812_N_STRIPS, 800000);
+#else
     uint offset = pio_add_program(pio, &ws2812_program);
 
-    ws2812_program_init(pio, sm, offset, TX_PIN, 800000, true);
+    ws2812_program_init(pio, sm, offset, TX_PIN, 800000, WS2812_PIXEL_BITS == 32);
+#endif
+}
+
+
+/*
+Transposes a 32x32 bit matrix in place, so that bit 31 - j of row i ends up in bit 31 - i of row j
+Swaps ever smaller blocks across the diagonal, 16x16 first, which takes 5 * 16 masked swaps rather than 1024 bit moves
+(Hacker's Delight, 7-3)
+*/
+static void transpose32(uint32_t *a)
+{
+    int j, k;
+    uint32_t m, t;
+
+    for (j = 16, m = 0x0000ffff; j != 0; j >>= 1, m ^= m << j) {
+        for (k = 0; k < 32; k = (k + j + 1) & ~j) {
+            t = (a[k] ^ (a[k + j] >> j)) & m;
+            a[k] ^= t;
+            a[k + j] ^= t << j;
+        }
+    }
+}
+
+
+/*
+Turns pixel i of every strip into its 32 bit planes. Only the first WS2812_PIXEL_BITS of them are sent, the rest
+hold the low byte a 24-bit pixel never shifts out
+*/
+static void transpose_pixel(const uint32_t *column, int i, uint32_t *planes)
+{
+    int s;
+
+    // strip s goes in row 31 - s, so that after the transpose it is bit s of every plane
+    for (s = 0; s < 32 - WS2812_N_STRIPS; s++)
+        planes[s] = 0;
+    for (s = 0; s < WS2812_N_STRIPS; s++)
+        planes[31 - s] = column[s * WS2812_N_PIXELS + i];
+    transpose32(planes);
+}
+
+
+void ws2812_transpose_column(const uint32_t *column, uint32_t *planes)
+{
+    int i;
+#if WS2812_PIXEL_BITS == 32
+    for (i = 0; i < WS2812_N_PIXELS; i++)
+        transpose_pixel(column, i, &planes[i * 32]);
+#else
+    uint32_t pixel_planes[32];
+    int b;
+
+    // the planes of one pixel are followed straight away by those of the next, so the unsent ones can't be kept
+    for (i = 0; i < WS2812_N_PIXELS; i++) {
+        transpose_pixel(column, i, pixel_planes);
+        for (b = 0; b < WS2812_PIXEL_BITS; b++)
+            planes[i * WS2812_PIXEL_BITS + b] = pixel_planes[b];
+    }
+#endif
+}
+
+
+void ws2812_put_column(const uint32_t *column)
+{
+    int i;
+#if WS2812_N_STRIPS > 1
+    uint32_t planes[32];
+    int b;
+
+    // one pixel at a time, so only one pixel's planes are ever on the stack
+    for (i = 0; i < WS2812_N_PIXELS; i++) {
+        transpose_pixel(column, i, planes);
+        for (b = 0; b < WS2812_PIXEL_BITS; b++)
+            pio_sm_put_blocking(pio0, 0, planes[b]);
+    }
+#else
+    for (i = 0; i < WS2812_N_PIXELS; i++)
+        pio_sm_put_blocking(pio0, 0, column[i]);
+#endif
+}
+
+
+// DMA display engine state. Only touched by the alarm interrupt and the core it runs on
+static int dma_chan = -1;
+static int alarm_num = -1;
+static const uint32_t *swing_frames;
+static uint swing_n_pixels;
+static uint swing_n_frame_cols;     // columns in the ring swing_frames points to
+static uint swing_first;
+static uint32_t swing_col_step;     // frame columns from one column shown to the next, in WS2812_COL_STEP_ONE units
+static uint swing_n_cols;
+static bool swing_reverse;
+static uint64_t swing_start_us;
+static const uint32_t *swing_col_due_us;
+static volatile uint swing_next_col;
+static volatile uint swing_shown;
+static volatile uint swing_dropped;
+
+#if WS2812_N_STRIPS > 1
+// bit planes of the column on the wire, and of the next one. staged_col is the column in planes[staged], if any
+static uint32_t planes[2][WS2812_COLUMN_WORDS];
+static int staged;
+static int staged_col = -1;
+#endif
+
+
+// returns the frame column the i'th column of the swing shows
+static inline uint swing_col(uint i)
+{
+    uint col;
+
+    i = swing_reverse ? swing_n_cols - i - 1 : i;
+    col = swing_first + i * swing_col_step / WS2812_COL_STEP_ONE;
+
+    // the swing spans less than the ring, so it wraps around at most once
+    return col < swing_n_frame_cols ? col : col - swing_n_frame_cols;
+}
+
+
+// starts the DMA sending a column of the swing
+static void send_column(uint col)
+{
+#if WS2812_N_STRIPS > 1
+    // the column is normally transposed ahead of time, unless columns were skipped since
+    if (staged_col != (int)col)
+        ws2812_transpose_column(&swing_frames[col * swing_n_pixels], planes[staged]);
+    dma_channel_transfer_from_buffer_now(dma_chan, planes[staged], WS2812_COLUMN_WORDS);
+    staged ^= 1;
+    staged_col = -1;
+#else
+    dma_channel_transfer_from_buffer_now(dma_chan, &swing_frames[col * swing_n_pixels], swing_n_pixels);
+#endif
+}
+
+
+// time the i'th column of the swing is due
+static inline uint64_t swing_col_due(uint i)
+{
+    return swing_start_us + swing_col_due_us[i];
+}
+
+
+// how late the i'th column of the swing is now, negative if it isn't due yet
+static inline int64_t swing_col_late_us(uint i)
+{
+    return (int64_t)(time_us_64() - swing_col_due(i));
+}
+
+
+static void ws2812_dma_alarm(uint alarm)
+{
+    int64_t late_us = swing_col_late_us(swing_next_col);
+    uint skipped = 0;
+
+    // send the column that is due. The column period leaves enough time for the last one to finish
+    if (!dma_channel_is_busy(dma_chan)) {
+        send_column(swing_col(swing_next_col));
+        swing_shown++;
+        if (late_us >= TRACE_COLUMN_LATE_US)
+            TRACE(TRACE_COLUMN_LATE, swing_next_col, (uint32_t)late_us);
+    }
+    else {
+        // the column before is still going out, which the column period was meant to rule out
+        swing_dropped++;
+        TRACE(TRACE_COLUMN_DROPPED, swing_next_col, late_us > 0 ? (uint32_t)late_us : 0);
+    }
+    swing_next_col++;
+
+    // schedule the next column against the start of the swing. If it is already too late for a column,
+    // skip it rather than running it into the one before
+    while (swing_next_col < swing_n_cols && hardware_alarm_set_target(alarm, from_us_since_boot(swing_col_due(swing_next_col)))) {
+        swing_next_col++;
+        skipped++;
+    }
+    if (skipped > 0) {
+        late_us = swing_col_late_us(swing_next_col - skipped);
+        TRACE(TRACE_COLUMN_SKIP, skipped, late_us > 0 ? (uint32_t)late_us : 0);
+    }
+    if (swing_next_col == swing_n_cols)
+        TRACE(TRACE_SWING_END, swing_shown, swing_n_cols);
+
+#if WS2812_N_STRIPS > 1
+    // transpose the next column into the planes the DMA is not reading, while it sends this one
+    if (swing_next_col < swing_n_cols) {
+        staged_col = (int)swing_col(swing_next_col);
+        ws2812_transpose_column(&swing_frames[staged_col * swing_n_pixels], planes[staged]);
+    }
+#endif
+}
+
+
+void setup_ws2812_dma()
+{
+    dma_chan = dma_claim_unused_channel(true);
+
+    // 32-bit words from the frame buffer into the TX FIFO, as fast as the state machine takes them
+    dma_channel_config c = dma_channel_get_default_config(dma_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, pio_get_dreq(pio0, 0, true));
+    dma_channel_configure(dma_chan, &c, &pio0->txf[0], NULL, 0, false);
+
+    alarm_num = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(alarm_num, ws2812_dma_alarm);
+}
+
+
+uint32_t ws2812_dma_min_col_time_us(uint n_pixels)
+{
+    // several strips are sent side by side, so a column takes as long as one strip of it
+    return n_pixels / WS2812_N_STRIPS * WS2812_PIXEL_US + WS2812_END_SLEEP_US;
+}
+
+
+void ws2812_dma_show_swing(const uint32_t *frames, uint n_pixels, uint n_frame_cols, uint first, uint n_cols,
+                           uint32_t col_step, bool reverse, uint64_t start_us, const uint32_t *col_due_us)
+{
+    ws2812_dma_stop();
+#if WS2812_N_STRIPS > 1
+    staged_col = -1;
+#endif
+
+    swing_frames = frames;
+    swing_n_pixels = n_pixels;
+    swing_n_frame_cols = n_frame_cols;
+    swing_first = first;
+    swing_col_step = col_step;
+    swing_n_cols = n_cols;
+    swing_reverse = reverse;
+    swing_start_us = start_us;
+    swing_col_due_us = col_due_us;
+    swing_next_col = 0;
+    swing_shown = 0;
+    swing_dropped = 0;
+
+    if (n_cols == 0)
+        return;
+
+    // the first column may already be due
+    if (hardware_alarm_set_target(alarm_num, from_us_since_boot(swing_col_due(0))))
+        ws2812_dma_alarm(alarm_num);
+}
+
+
+void ws2812_dma_stop()
+{
+    hardware_alarm_cancel(alarm_num);
+    swing_next_col = swing_n_cols;
+}
+
+
+void ws2812_dma_blank()
+{
+    ws2812_dma_stop();
+    while (dma_channel_is_busy(dma_chan))
+        tight_loop_contents();
+    put_pixels_on(0);
+}
+
+
+uint ws2812_dma_columns_shown()
+{
+    return swing_shown;
+}
+
+
+uint ws2812_dma_columns_dropped()
+{
+    return swing_dropped;
 }
@@ -0,0 +1,724 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/sync.h"
+
+#include "pov.h"
+#include "neopixels.h"
+#include "ADXL343.h"
+#include "font.h"
+#include "trace.h"
+
+// framebuffer ring, see POV_RING_COLUMNS. The DMA engine only ever reads the window from display_origin on, and the
+// window only moves between swings
+static uint32_t framebuffer[POV_FRAMEBUFFER_WORDS];
+static volatile uint display_origin;
+static volatile uint scroll_pending;    // columns to move the window on at the next swing, 0 if there is no swap
+
+// fraction of the way through a swing (out of 65536) every display column is due at, see POV_VELOCITY_PROFILE, and
+// the smallest fraction between two neighbouring columns. Used until a profile has been fitted
+static uint16_t column_profile[N_DISPLAY_COLUMNS];
+static uint16_t column_min_step;
+
+// columns the smallest step of a profile is averaged over, as a fitted one is noisy from one column to the next
+#define PROFILE_STEP_SPAN       (N_DISPLAY_COLUMNS >= 16 ? N_DISPLAY_COLUMNS / 16 : 1)
+
+// when the columns of a swing are due, from its start. The DMA engine reads one table while the next swing's is written
+static uint32_t column_due_us[2][N_DISPLAY_COLUMNS];
+static int due_table;
+
+pov_swing_ring pov_swings;
+volatile pov_display_stats pov_stats;
+
+
+// the smallest fraction of a swing between neighbouring columns of profile
+static uint16_t min_profile_step(const uint16_t *profile)
+{
+    uint32_t step, min_step = 0xffff;
+    int c;
+
+    for (c = PROFILE_STEP_SPAN; c < N_DISPLAY_COLUMNS; c++) {
+        step = (uint32_t)(profile[c] - profile[c - PROFILE_STEP_SPAN]) / PROFILE_STEP_SPAN;
+        if (step < min_step)
+            min_step = step;
+    }
+    return (uint16_t)(min_step > 0 ? min_step : 1);
+}
+
+
+#if POV_VELOCITY_PROFILE == 2
+/*
+Fits the profile of display direction dir to the half swing from sample n0 to n1, if the samples are still in the
+ring. The acceleration a is integrated twice, sample by sample, into v and x. The wand is at rest at both ends, so
+the mean acceleration S / n is taken out, and the position k samples in is then x - S k (k + 1) / 2n. Everything is
+kept 2n times larger, which is all integers, in X
+*/
+static void fit_profile(pov_detector *detector, uint dir, uint32_t n0, uint32_t n1)
+{
+    uint32_t n = n1 - n0, k, frac, num, den;
+    int32_t v = 0, s;
+    int64_t sum_v = 0, w = 0, x = 0, x_prev, d, level, step, over;
+    uint16_t *profile = detector->profile[dir];
+    uint c = 0, shift;
+
+    if (n < POV_PROFILE_MIN_SAMPLES || detector->n_samples - n0 > POV_PROFILE_SAMPLES)
+        return;
+
+    // the total acceleration S, and the distance covered, d = X at n1
+    for (k = 1; k <= n; k++) {
+        v += detector->samples[(n0 + k) % POV_PROFILE_SAMPLES];
+        sum_v += v;
+    }
+    s = v;
+    d = 2 * (int64_t)n * sum_v - (int64_t)s * n * (n + 1);
+
+    // X moves on by 2 (n v - S k) a sample. The wand goes whichever way, so the position is counted towards d.
+    // A wand that went nowhere has no profile
+    step = (d < 0 ? -d : d) / N_DISPLAY_COLUMNS;
+    if (step == 0)
+        return;
+    level = step / 2;
+    for (k = 1; k <= n && c < N_DISPLAY_COLUMNS; k++) {
+        w += (int64_t)n * detector->samples[(n0 + k) % POV_PROFILE_SAMPLES] - s;
+        x_prev = x;
+        x += d < 0 ? -2 * w : 2 * w;
+
+        // every column passed since the last sample, placed between the two samples. How far X moved is brought
+        // down to 16 bits for the division
+        while (c < N_DISPLAY_COLUMNS && x >= level) {
+            over = level - x_prev;
+            for (shift = 0; ((x - x_prev) >> shift) >= (1 << 16); shift++)
+                ;
+            den = (uint32_t)((x - x_prev) >> shift);
+            num = over > 0 ? (uint32_t)(over >> shift) : 0;
+            frac = ((k - 1) << 16) + (den > 0 ? (num << 16) / den : 0);
+            frac /= n;
+            profile[c++] = frac < 0xffff ? frac : 0xffff;
+            level += step;
+        }
+    }
+    // rounding can leave the last column just short of the end
+    while (c < N_DISPLAY_COLUMNS)
+        profile[c++] = 0xffff;
+
+    detector->profile_min_step[dir] = min_profile_step(profile);
+    detector->fitted[dir] = true;
+}
+#endif
+
+
+// gives swing the profile fitted to the last half swing in its direction, or to the last one the other way
+static void swing_profile(const pov_detector *detector, pov_swing *swing)
+{
+    uint dir = detector->fitted[swing->dir] ? swing->dir : !swing->dir;
+
+    swing->fitted = detector->fitted[dir];
+    if (!swing->fitted)
+        return;
+    memcpy(swing->profile, detector->profile[dir], sizeof(swing->profile));
+    swing->profile_min_step = detector->profile_min_step[dir];
+}
+
+
+void pov_detector_init(pov_detector *detector)
+{
+    detector->prev_ax_raw = 0;
+    // the first sample is always the most extreme yet
+    detector->extreme_ax_raw = INT16_MAX;
+    detector->extreme_us = 0;
+    detector->extreme_end_us = 0;
+    detector->extreme_n = 0;
+    detector->extreme_end_n = 0;
+    detector->reversal_ax_raw = 0;
+    detector->mid_ax_raw = 0;
+    detector->crossing_us = 0;
+    detector->prev_dir_change_time = 0;
+    detector->prev_swing_time_length = 0;
+    // the detector starts out as if it had been seeing '0' forever
+    detector->hidden_dir = 0;
+    detector->hidden_run = DIR_RUN_LENGTH_MAX;
+    detector->display_dir = 0;
+    detector->run_length = DIR_RUN_LENGTH;
+    detector->n_reversals = 0;
+    detector->seq = 0;
+    detector->anticipated = false;
+    detector->anticipated_us = 0;
+    predictor_init(&detector->predictor, POV_PREDICTOR);
+    detector->n_samples = 0;
+    detector->reversal_n = 0;
+    detector->fit_pending = false;
+    detector->fitted[0] = false;
+    detector->fitted[1] = false;
+}
+
+
+void pov_detector_set_run_length(pov_detector *detector, uint run_length)
+{
+    if (run_length < 1)
+        run_length = 1;
+    if (run_length > DIR_RUN_LENGTH_MAX)
+        run_length = DIR_RUN_LENGTH_MAX;
+    detector->run_length = (uint8_t)run_length;
+}
+
+
+bool pov_update_direction(pov_detector *detector, uint64_t now, int16_t ax_raw)
+{
+    bool changed = false;
+    uint8_t dir;
+    uint32_t n = detector->n_samples++;
+
+    detector->samples[n % POV_PROFILE_SAMPLES] = ax_raw;
+
+    // caculate the direction of the wand based on jerk. The sample period is positive, so the jerk has the sign
+    // of the change in acceleration: negative is 'left' (0), positive is 'right' (1)
+    if (ax_raw < detector->prev_ax_raw)
+        dir = 0;
+    else if (ax_raw > detector->prev_ax_raw)
+        dir = 1;
+    else
+        // otherwise, assume wand is continuing in the same direction
+        dir = detector->hidden_dir;
+
+    // count how long the hidden direction has held for
+    if (dir != detector->hidden_dir) {
+        detector->hidden_dir = dir;
+        detector->hidden_run = 1;
+    }
+    else if (detector->hidden_run < DIR_RUN_LENGTH_MAX) {
+        detector->hidden_run++;
+    }
+
+    // the wand turns around at the extreme of the acceleration, which the jerk swings towards. The counts are
+    // coarse, so the extreme is often a plateau, and the turnaround is in the middle of it
+    if (ax_raw == detector->extreme_ax_raw) {
+        detector->extreme_end_us = now;
+        detector->extreme_end_n = n;
+    }
+    else if (detector->display_dir ? ax_raw > detector->extreme_ax_raw : ax_raw < detector->extreme_ax_raw) {
+        detector->extreme_ax_raw = ax_raw;
+        detector->extreme_us = now;
+        detector->extreme_end_us = now;
+        detector->extreme_n = n;
+        detector->extreme_end_n = n;
+    }
+    if (detector->crossing_us == 0 && (detector->display_dir ? ax_raw >= detector->mid_ax_raw : ax_raw <= detector->mid_ax_raw))
+        detector->crossing_us = now;
+
+    // update the displayed direction based on the hidden direction, using hysteresis.
+    if (detector->hidden_dir != detector->display_dir && detector->hidden_run >= detector->run_length) {
+        detector->display_dir = detector->hidden_dir;
+        changed = true;
+    }
+
+    if (changed) {
+        pov_swing swing;
+        uint64_t reversal, next_reversal;
+        uint32_t reversal_n;
+        int64_t err;
+
+        // the wand turned around at the extreme, not run_length samples later where the reversal was confirmed.
+        // The fastest point of the new swing is expected halfway between this extreme and the last
+        reversal = detector->extreme_us + (detector->extreme_end_us - detector->extreme_us) / 2;
+        reversal_n = detector->extreme_n + (detector->extreme_end_n - detector->extreme_n) / 2;
+        detector->mid_ax_raw = (int16_t)(((int32_t)detector->reversal_ax_raw + detector->extreme_ax_raw) / 2);
+        detector->reversal_ax_raw = detector->extreme_ax_raw;
+        detector->crossing_us = 0;
+        detector->extreme_ax_raw = ax_raw;
+        detector->extreme_us = now;
+        detector->extreme_end_us = now;
+        detector->extreme_n = n;
+        detector->extreme_end_n = n;
+
+        // the half swing that just ended was shown in the direction before this one, and is fitted once the batch is
+        // through. A fit still waiting from the last reversal is dropped
+        detector->fit_pending = detector->n_reversals > 0;
+        detector->fit_dir = !detector->display_dir;
+        detector->fit_n = detector->reversal_n;
+        detector->reversal_n = reversal_n;
+
+        // the direction of the wand has changed - update the amount of time the swing that just ended took
+        detector->prev_swing_time_length = reversal - detector->prev_dir_change_time;
+        detector->prev_dir_change_time = reversal;
+        detector->n_reversals++;
+
+        swing.reversal_us = reversal;
+        swing.period_us = detector->prev_swing_time_length > UINT32_MAX ? UINT32_MAX : (uint32_t)detector->prev_swing_time_length;
+        swing.dir = detector->display_dir;
+
+        // spread the columns up to the predicted end of this swing. Until the predictor has seen a full swing,
+        // fall back on the length of the last one
+        predictor_update(&detector->predictor, reversal);
+        next_reversal = predictor_next_reversal(&detector->predictor);
+        if (next_reversal > reversal)
+            swing.predicted_us = next_reversal - reversal > UINT32_MAX ? UINT32_MAX : (uint32_t)(next_reversal - reversal);
+        else
+            swing.predicted_us = swing.period_us;
+        swing.confidence = detector->predictor.confidence;
+        swing_profile(detector, &swing);
+
+        // a swing anticipated close enough to the reversal is already on display. Otherwise restart it from the
+        // reversal, which puts the columns back where they belong
+        err = (int64_t)(reversal - detector->anticipated_us);
+        if (!detector->anticipated || (uint64_t)(err < 0 ? -err : err) > swing.period_us / POV_ANTICIPATE_TOLERANCE_DIV) {
+            swing.seq = ++detector->seq;
+            signal_dirchange(&swing);
+            TRACE(TRACE_REVERSAL, swing.dir, swing.seq);
+        }
+        else {
+            TRACE(TRACE_REVERSAL, swing.dir, 0);
+        }
+        detector->anticipated = false;
+    }
+
+    detector->prev_ax_raw = ax_raw;
+
+    return changed;
+}
+
+
+void pov_fit_profile(pov_detector *detector)
+{
+    if (!detector->fit_pending)
+        return;
+    detector->fit_pending = false;
+#if POV_VELOCITY_PROFILE == 2
+    fit_profile(detector, detector->fit_dir, detector->fit_n, detector->reversal_n);
+#endif
+}
+
+
+bool pov_anticipate_reversal(pov_detector *detector, uint64_t now)
+{
+    pov_swing swing;
+    uint64_t next_reversal, pll_reversal;
+    int64_t err;
+    const predictor *p = &detector->predictor;
+
+    if (detector->anticipated || p->confidence < POV_ANTICIPATE_CONFIDENCE || detector->crossing_us == 0)
+        return false;
+
+    // the swing is close to symmetric, so the wand takes as long from its fastest point to the next turnaround as
+    // it took from the last turnaround to get there. The predictor has to agree, which rules out swings that are
+    // changing shape
+    next_reversal = 2 * detector->crossing_us - detector->prev_dir_change_time;
+    pll_reversal = predictor_next_reversal(p);
+    err = (int64_t)(next_reversal - pll_reversal);
+    if (pll_reversal == 0 || (uint64_t)(err < 0 ? -err : err) > p->period_us / POV_ANTICIPATE_TOLERANCE_DIV)
+        return false;
+
+    // only a reversal due before the next batch is read needs to be anticipated. One that is already overdue is
+    // left to the hysteresis
+    if (next_reversal > now + POV_ANTICIPATE_LEAD_US || next_reversal + p->period_us / POV_ANTICIPATE_TOLERANCE_DIV < now)
+        return false;
+
+    swing.seq = ++detector->seq;
+    swing.reversal_us = next_reversal;
+    swing.period_us = (uint32_t)(next_reversal - detector->prev_dir_change_time);
+    swing.predicted_us = p->period_us;
+    swing.dir = !detector->display_dir;
+    swing.confidence = p->confidence;
+    swing_profile(detector, &swing);
+
+    detector->anticipated = true;
+    detector->anticipated_us = next_reversal;
+    signal_dirchange(&swing);
+    TRACE(TRACE_ANTICIPATE, swing.dir, swing.seq);
+    return true;
+}
+
+
+void signal_dirchange(const pov_swing *swing)
+{
+    // tell core1 to start displaying a new swing. The swing itself goes through the ring, the FIFO just wakes
+    // core1 up. If the FIFO is full core1 already has a doorbell waiting, so this one can be skipped
+    if (!pov_swing_ring_push(&pov_swings, swing))
+        TRACE(TRACE_SWING_DROP, 0, swing->seq);
+    if (multicore_fifo_wready())
+        multicore_fifo_push_blocking(swing->seq);
+    else
+        TRACE(TRACE_DOORBELL_SKIP, 0, swing->seq);
+}
+
+
+void pov_swing_ring_init(pov_swing_ring *ring)
+{
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+}
+
+
+bool pov_swing_ring_push(pov_swing_ring *ring, const pov_swing *swing)
+{
+    uint32_t head = ring->head;
+
+    if (head - ring->tail == POV_SWING_RING_SIZE) {
+        ring->dropped++;
+        return false;
+    }
+
+    ring->slots[head % POV_SWING_RING_SIZE] = *swing;
+
+    // the slot must be written before the consumer can see the new head
+    __dmb();
+    ring->head = head + 1;
+    return true;
+}
+
+
+bool pov_swing_ring_pop(pov_swing_ring *ring, pov_swing *out)
+{
+    uint32_t tail = ring->tail;
+
+    if (ring->head == tail)
+        return false;
+
+    // the slot must not be read before the head that published it
+    __dmb();
+    *out = ring->slots[tail % POV_SWING_RING_SIZE];
+
+    // and must be read before the producer can reuse it
+    __dmb();
+    ring->tail = tail + 1;
+    return true;
+}
+
+
+uint32_t *pov_back_column(uint c)
+{
+    uint col = display_origin + N_DISPLAY_COLUMNS + c;
+
+    if (scroll_pending > 0)
+        return NULL;
+    if (col >= POV_RING_COLUMNS)
+        col -= POV_RING_COLUMNS;
+    return &framebuffer[col * WS2812_COLUMN_PIXELS];
+}
+
+
+int pov_render_columns(const uint32_t *columns, uint32_t color_on, uint32_t color_off)
+{
+    int i;
+
+    if (scroll_pending > 0)
+        return -1;
+
+    for (i = 0; i < N_DISPLAY_COLUMNS; i++)
+        ws2812_mask_column(columns[i], color_on, color_off, pov_back_column(i));
+
+    return 0;
+}
+
+
+void pov_swap_buffers()
+{
+    pov_scroll_buffers(N_DISPLAY_COLUMNS);
+}
+
+
+void pov_scroll_buffers(uint n_cols)
+{
+    scroll_pending = n_cols;
+}
+
+
+int pov_renderer_start(pov_renderer *renderer, const char *text, int scale, int scroll, uint32_t color_on,
+                       uint32_t color_off)
+{
+    size_t len = strlen(text);
+    bool marquee;
+
+    if (scale < 1 || scroll < 0 || scroll > N_DISPLAY_COLUMNS || len > POV_MAX_TEXT_LEN)
+        return -1;
+    marquee = font_text_width(text, scale) > N_DISPLAY_COLUMNS;
+    if (marquee && scroll == 0)
+        return -1;
+    if (!marquee && build_columns(text, renderer->columns, N_DISPLAY_COLUMNS, scale) < 0)
+        return -1;
+
+    memcpy(renderer->text, text, len + 1);
+    renderer->scale = scale;
+    renderer->scroll = scroll;
+    renderer->color_on = color_on;
+    renderer->color_off = color_off;
+    renderer->marquee = marquee;
+    renderer->text_pos = 0;
+    renderer->glyph_col = 0;
+    renderer->repeat = 0;
+    renderer->image = NULL;
+    renderer->render_cols = N_DISPLAY_COLUMNS;
+    renderer->next_col = 0;
+    return 0;
+}
+
+
+int pov_renderer_start_image(pov_renderer *renderer, const image *img, uint32_t color_off)
+{
+    if (img->width > N_DISPLAY_COLUMNS || img->height > WS2812_COLUMN_PIXELS)
+        return -1;
+    if (image_decoder_start(&renderer->decoder, img, 0) < 0)
+        return -1;
+
+    renderer->color_off = color_off;
+    renderer->image = img;
+    renderer->frame = 0;
+    renderer->render_cols = N_DISPLAY_COLUMNS;
+    renderer->next_col = 0;
+    return 0;
+}
+
+
+// decodes the next image column into column, centered like the text
+static void render_image_column(pov_renderer *renderer, uint32_t *column)
+{
+    const image *img = renderer->image;
+    int c = renderer->next_col - (N_DISPLAY_COLUMNS - img->width) / 2;
+    int j = 0;
+
+    if (c >= 0 && c < img->width) {
+        image_decode_column(&renderer->decoder, column);
+        j = img->height;
+    }
+    for (; j < WS2812_COLUMN_PIXELS; j++)
+        column[j] = renderer->color_off;
+}
+
+
+// lays out the next column of a marquee straight from the font, and moves on to the one after
+static uint32_t marquee_next_column(pov_renderer *renderer)
+{
+    const font_glyph *glyph;
+    uint32_t cp, bits = 0;
+    int n = font_decode_utf8(&renderer->text[renderer->text_pos], &cp);
+    int width = POV_MARQUEE_GAP;
+
+    // past the end of the text is the gap, so that its end never runs into its start
+    if (n > 0) {
+        glyph = font_find_glyph(cp);
+        width = glyph->width + FONT_SPACING;
+        if (renderer->glyph_col < glyph->width)
+            bits = font_columns[glyph->offset + renderer->glyph_col];
+    }
+
+    if (++renderer->repeat < renderer->scale)
+        return bits;
+    renderer->repeat = 0;
+    if (++renderer->glyph_col < width)
+        return bits;
+    renderer->glyph_col = 0;
+    renderer->text_pos = n > 0 ? renderer->text_pos + n : 0;
+    return bits;
+}
+
+
+bool pov_renderer_step(pov_renderer *renderer)
+{
+    uint32_t *column;
+
+    if (renderer->next_col >= renderer->render_cols)
+        return false;
+
+    // the back buffer is spoken for until the last render has been swapped in
+    column = pov_back_column(renderer->next_col);
+    if (column == NULL)
+        return false;
+
+    if (renderer->image != NULL) {
+        render_image_column(renderer, column);
+    }
+    else if (renderer->marquee) {
+        ws2812_mask_column(marquee_next_column(renderer), renderer->color_on, renderer->color_off, column);
+    }
+    else {
+        ws2812_mask_column(renderer->columns[renderer->next_col], renderer->color_on, renderer->color_off, column);
+    }
+
+    if (++renderer->next_col < renderer->render_cols)
+        return true;
+    pov_scroll_buffers(renderer->render_cols);
+
+    // the next frame is decoded while this one is shown, and swapped in at the swing after
+    if (renderer->image != NULL && renderer->image->n_frames > 1) {
+        renderer->frame = (renderer->frame + 1) % renderer->image->n_frames;
+        image_decoder_start(&renderer->decoder, renderer->image, renderer->frame);
+        renderer->next_col = 0;
+        return true;
+    }
+
+    // likewise the columns a marquee scrolls on by, which are all that change from one swing to the next
+    if (renderer->image == NULL && renderer->marquee) {
+        renderer->render_cols = renderer->scroll;
+        renderer->next_col = 0;
+        return true;
+    }
+    return false;
+}
+
+
+bool pov_swing_pending()
+{
+    return pov_swings.head != pov_swings.tail;
+}
+
+
+void pov_display_init()
+{
+    int c;
+    uint32_t frac;
+
+    for (c = 0; c < N_DISPLAY_COLUMNS; c++) {
+#if POV_VELOCITY_PROFILE
+        // the middle of column c is (c + 0.5) / N_DISPLAY_COLUMNS of the way across, which the wand reaches
+        // acos(1 - 2 * that) / pi of the way through the swing
+        frac = (uint32_t)lround(acos(1.0 - (2.0 * c + 1.0) / N_DISPLAY_COLUMNS) / M_PI * 65536.0);
+#else
+        frac = (uint32_t)c * 65536 / N_DISPLAY_COLUMNS;
+#endif
+        column_profile[c] = frac < 0xffff ? frac : 0xffff;
+    }
+    column_min_step = min_profile_step(column_profile);
+}
+
+
+// fills in the times the columns of a swing are due at, scaling the profile to its predicted length
+static const uint32_t *swing_column_times(const uint16_t *profile, uint n_cols, uint first, uint32_t step,
+                                          uint32_t predicted_us)
+{
+    uint32_t *due = column_due_us[due_table ^= 1];
+    uint32_t min_col_time_us = ws2812_dma_min_col_time_us(WS2812_COLUMN_PIXELS);
+    uint32_t t;
+    uint i;
+
+    for (i = 0; i < n_cols; i++) {
+        t = (uint32_t)(((uint64_t)predicted_us * profile[first + i * step / WS2812_COL_STEP_ONE]) >> 16);
+
+        // never closer together than the strip can take them, which is also how the columns are spaced until there is
+        // a prediction
+        if (i > 0 && t < due[i - 1] + min_col_time_us)
+            t = due[i - 1] + min_col_time_us;
+        due[i] = t;
+    }
+    return due;
+}
+
+
+uint pov_column_layout(uint n_cols, uint32_t *step)
+{
+    *step = N_DISPLAY_COLUMNS * WS2812_COL_STEP_ONE / n_cols;
+
+    // center the columns that are shown, the skipped ones are spread over both ends
+    return (N_DISPLAY_COLUMNS - 1 - (n_cols - 1) * *step / WS2812_COL_STEP_ONE) / 2;
+}
+
+
+int pov_display_next_swing()
+{
+    // wait for core0 to ring the doorbell. The swing already started keeps running on the DMA engine
+    while (pov_swings.head == pov_swings.tail) {
+        if (multicore_fifo_rvalid())
+            multicore_fifo_pop_blocking();
+        else
+            tight_loop_contents();
+    }
+
+    return pov_start_next_swing();
+}
+
+
+int pov_start_next_swing()
+{
+    pov_swing swing;
+    const uint16_t *profile;
+    const uint32_t *due;
+    uint32_t budget, step, min_step;
+    uint n_cols = N_DISPLAY_COLUMNS, first;
+    int shown;
+
+    // the doorbells have done their job, throw them away along with every swing but the newest
+    while (multicore_fifo_rvalid())
+        multicore_fifo_pop_blocking();
+    if (!pov_swing_ring_pop(&pov_swings, &swing))
+        return -1;
+    while (pov_swing_ring_pop(&pov_swings, &swing))
+        ;
+    profile = swing.fitted ? swing.profile : column_profile;
+    min_step = swing.fitted ? swing.profile_min_step : column_min_step;
+
+    // the column budget is how many columns fit in the predicted swing. If all of them don't, spread the budget
+    // evenly over the framebuffer instead, so a fast swing shows the whole image a little coarser rather than the
+    // start of it. The columns come closest together where the profile is steepest, which is what has to fit.
+    // Until there is a prediction, the columns are shown as fast as they can be
+    budget = (uint32_t)((uint64_t)swing.predicted_us * min_step * N_DISPLAY_COLUMNS /
+                        ((uint64_t)ws2812_dma_min_col_time_us(WS2812_COLUMN_PIXELS) << 16));
+    if (swing.predicted_us > 0 && budget < N_DISPLAY_COLUMNS)
+        n_cols = budget > 0 ? budget : 1;
+    first = pov_column_layout(n_cols, &step);
+    due = swing_column_times(profile, n_cols, first, step, swing.predicted_us);
+
+    // the swing boundary is the only time the window can move without tearing the message
+    if (scroll_pending > 0) {
+        display_origin = (display_origin + scroll_pending) % POV_RING_COLUMNS;
+        scroll_pending = 0;
+    }
+    first += display_origin;
+    if (first >= POV_RING_COLUMNS)
+        first -= POV_RING_COLUMNS;
+
+    // hand the whole swing, in the proper direction, to the DMA engine. This cuts short the swing before it
+    shown = (int)ws2812_dma_columns_shown();
+    pov_stats.columns_dropped += ws2812_dma_columns_dropped();
+    ws2812_dma_show_swing(framebuffer, WS2812_COLUMN_PIXELS, POV_RING_COLUMNS, first, n_cols, step, swing.dir == 0,
+                          swing.reversal_us, due);
+
+    if (pov_stats.swings > 0 && (uint)shown < pov_stats.last_columns) {
+        pov_stats.overruns++;
+        pov_stats.columns_cut += pov_stats.last_columns - shown;
+        TRACE(TRACE_OVERRUN, shown, pov_stats.last_columns - shown);
+    }
+    TRACE(TRACE_SWING_START, n_cols, swing.seq);
+    if (n_cols < N_DISPLAY_COLUMNS)
+        pov_stats.decimated++;
+    pov_stats.swings++;
+    pov_stats.last_seq = swing.seq;
+    pov_stats.last_columns = n_cols;
+
+    return shown;
+}
+
+
+int build_columns(const char *text, uint32_t *columns, int n_cols, int scale)
+{
+    const font_glyph *glyph;
+    uint32_t cp;
+    int i, j, k, n, col;
+    int width;
+
+    // check that the message will fit
+    if (scale < 1)
+        return -1;
+    width = font_text_width(text, scale);
+    if (width > n_cols)
+        return -1;
+
+    for (i = 0; i < n_cols; i++)
+        columns[i] = 0;
+
+    // glyphs are only as wide as their ink, with FONT_SPACING blank columns between them
+    col = (n_cols - width) / 2;
+    while ((n = font_decode_utf8(text, &cp)) > 0) {
+        glyph = font_find_glyph(cp);
+        for (j = 0; j < glyph->width; j++) {
+            for (k = 0; k < scale; k++)
+                columns[col++] = font_columns[glyph->offset + j];
+        }
+        col += FONT_SPACING * scale;
+        text += n;
+    }
+
+    return 0;
+}
@@ -0,0 +1,98 @@
+#include <string.h>
+
+#include "pico/stdlib.h"
+
+#include "predictor.h"
+
+
+void predictor_init(predictor *p, predictor_kind kind)
+{
+    p->kind = kind;
+    p->prev_reversal_us = 0;
+    p->phase_us = 0;
+    p->period_us = 0;
+    p->confidence = 0;
+}
+
+
+// drops whatever was learnt, and starts over from a single swing
+static void predictor_relock(predictor *p, uint64_t reversal_us, uint32_t measured_us)
+{
+    p->phase_us = reversal_us;
+    p->period_us = measured_us;
+    p->confidence = 0;
+}
+
+
+void predictor_update(predictor *p, uint64_t reversal_us)
+{
+    uint64_t measured;
+    int64_t err;
+    uint32_t abs_err;
+
+    measured = p->prev_reversal_us == 0 ? 0 : reversal_us - p->prev_reversal_us;
+    p->prev_reversal_us = reversal_us;
+
+    // the first reversal, or the first after a rest, says nothing about how fast the wand is swinging
+    if (measured == 0 || measured > PREDICTOR_MAX_PERIOD_US) {
+        predictor_relock(p, reversal_us, 0);
+        return;
+    }
+    if (p->period_us == 0) {
+        predictor_relock(p, reversal_us, (uint32_t)measured);
+        return;
+    }
+
+    // how far off the last prediction was
+    err = (int64_t)(reversal_us - (p->phase_us + p->period_us));
+    abs_err = (uint32_t)(err < 0 ? -err : err);
+    p->confidence = abs_err >= p->period_us ? 0 : (uint8_t)(255 - (uint64_t)255 * abs_err / p->period_us);
+
+    switch (p->kind) {
+    case PREDICTOR_EWMA:
+        p->phase_us = reversal_us;
+        p->period_us = (uint32_t)((int64_t)p->period_us + ((int64_t)measured - p->period_us) / PREDICTOR_EWMA_DIV);
+        break;
+
+    case PREDICTOR_PLL:
+        // a reversal half a swing away from the prediction means the loop has lost the wand
+        if (abs_err > p->period_us / 2) {
+            predictor_relock(p, reversal_us, (uint32_t)measured);
+            break;
+        }
+        // phase error feeds both the phase (proportional) and the period (integral) of the loop
+        p->phase_us = p->phase_us + p->period_us + err / PREDICTOR_PLL_PHASE_DIV;
+        p->period_us = (uint32_t)((int64_t)p->period_us + err / PREDICTOR_PLL_PERIOD_DIV);
+        if (p->period_us == 0)
+            p->period_us = 1;
+        break;
+
+    case PREDICTOR_LAST:
+    default:
+        p->phase_us = reversal_us;
+        p->period_us = (uint32_t)measured;
+        break;
+    }
+}
+
+
+uint64_t predictor_next_reversal(const predictor *p)
+{
+    if (p->period_us == 0)
+        return 0;
+    return p->phase_us + p->period_us;
+}
+
+
+int predictor_kind_from_name(const char *name, predictor_kind *kind)
+{
+    if (strcmp(name, "last") == 0)
+        *kind = PREDICTOR_LAST;
+    else if (strcmp(name, "ewma") == 0)
+        *kind = PREDICTOR_EWMA;
+    else if (strcmp(name, "pll") == 0)
+        *kind = PREDICTOR_PLL;
+    else
+        return -1;
+    return 0;
+}
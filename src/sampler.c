@@ -0,0 +1,514 @@
+#include <string.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+#ifndef LIGHT_WAND_HOST
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/i2c.h"
+#include "hardware/spi.h"
+#include "hardware/timer.h"
+#endif
+
+#include "sampler.h"
+#include "trace.h"
+
+
+// the address of DATAX0 goes out first, then DATAX0 through DATAZ1 come back
+#define ENTRY_BYTES     7
+// the address of FIFO_STATUS or INT_SOURCE, and the register
+#define STATUS_BYTES    2
+
+typedef enum sampler_state_enum {
+    SAMPLER_IDLE,           // waiting for a batch. The alarm watches for a stall
+    SAMPLER_COUNTING,       // FIFO_STATUS is being read, for the entries in the batch. The alarm is the deadline
+    SAMPLER_READING,        // the entries and INT_SOURCE are being read. The alarm is the deadline
+    SAMPLER_POPPING,        // SPI only, between entries. The alarm starts the next one
+    SAMPLER_STOPPED         // stopped by sampler_stop, the bus is free
+} sampler_state;
+
+volatile sampler_counters sampler_stats;
+
+static adxl343 *acc;
+static uint int1;
+static uint batch_n;
+static uint32_t period_us;
+
+static volatile sampler_state state;
+static volatile bool stopping;
+static volatile uint8_t int_source;
+static uint read_n;                 // entries FIFO_STATUS counted, which the batch drains
+static uint64_t status_us;          // time FIFO_STATUS was read, by when the newest of them had been measured
+static uint64_t last_us;            // time the newest sample read so far was measured
+static bool resync;                 // samples were lost since last_us, so the next batch can't follow on from it
+static bool batch_waiting;          // another batch was signalled while this one was read
+static uint32_t start_us;
+
+// ADXL3XX_FIFO_SIZE entries and INT_SOURCE, as they come off the bus
+static uint8_t rx_bytes[ADXL3XX_FIFO_SIZE * ENTRY_BYTES + STATUS_BYTES];
+
+// ring of timestamped samples, pushed by the interrupts and popped by core 0
+static sampler_entry ring[ADX_SAMPLER_RING_SIZE];
+static volatile uint32_t ring_head;
+static volatile uint32_t ring_tail;
+
+#ifndef LIGHT_WAND_HOST
+static uint64_t deadline_us;
+static uint entry;                  // SPI only, the entry being read. INT_SOURCE comes after the last one
+static uint8_t count_rx[STATUS_BYTES];
+// every entry the FIFO can hold then INT_SOURCE, of which a batch sends the last read_n entries and INT_SOURCE
+static uint32_t i2c_cmds[ADXL3XX_FIFO_SIZE * ENTRY_BYTES + STATUS_BYTES];
+static uint32_t i2c_count_cmds[STATUS_BYTES];
+static const uint8_t spi_cmd[ENTRY_BYTES] = {
+    ADXL3XX_REG_DATAX0 | ADXL343_SPI_READ | ADXL343_SPI_MULTI_BYTE
+};
+static const uint8_t spi_status_cmd[STATUS_BYTES] = {
+    ADXL3XX_REG_INT_SOURCE | ADXL343_SPI_READ
+};
+static const uint8_t spi_count_cmd[STATUS_BYTES] = {
+    ADXL3XX_REG_FIFO_STATUS | ADXL343_SPI_READ
+};
+static int rx_chan = -1;
+static int tx_chan = -1;
+static int alarm_num = -1;
+#endif
+
+
+static void ring_push(uint64_t t_us, const uint8_t *bytes)
+{
+    sampler_entry *e;
+    uint32_t head = ring_head;
+
+    if (head - ring_tail == ADX_SAMPLER_RING_SIZE) {
+        sampler_stats.dropped++;
+        return;
+    }
+
+    e = &ring[head % ADX_SAMPLER_RING_SIZE];
+    e->t_us = t_us;
+    e->xyz.x = bytes[0] | (bytes[1] << 8);
+    e->xyz.y = bytes[2] | (bytes[3] << 8);
+    e->xyz.z = bytes[4] | (bytes[5] << 8);
+
+    // the sample must be written before core 0 can see the new head
+    __dmb();
+    ring_head = head + 1;
+    sampler_stats.samples++;
+}
+
+
+// pushes the read_n entries that were read. They follow on from the last batch a sample period apart, as the
+// accelerometer measured them, so batches never overlap. The newest is taken to have been measured as FIFO_STATUS
+// was read instead when samples were lost before the batch, or when the accelerometer's clock has drifted from the
+// pico's so far that the newest would be in the future, or older than the sample period before it
+static void batch_done(uint stride, uint skip, uint8_t source)
+{
+    uint64_t newest_us = last_us + (uint64_t)read_n * period_us;
+    uint i;
+
+    int_source |= source;
+    if (read_n == 0)
+        return;
+
+    // a full FIFO has been dropping its oldest samples
+    if (resync || read_n == ADXL3XX_FIFO_SIZE || newest_us > status_us ||
+        newest_us + 2 * period_us < status_us) {
+        newest_us = status_us;
+        sampler_stats.resyncs++;
+    }
+    resync = false;
+    last_us = newest_us;
+
+    for (i = 0; i < read_n; i++)
+        ring_push(newest_us - (uint64_t)(read_n - 1 - i) * period_us, &rx_bytes[i * stride + skip]);
+    sampler_stats.batches++;
+    TRACE(TRACE_I2C_READ, read_n, time_us_32() - start_us);
+}
+
+
+#ifndef LIGHT_WAND_HOST
+static void set_alarm(uint64_t t_us);
+
+static void spi_start_entry()
+{
+    bool status = entry == read_n;
+
+    gpio_put(acc->cs_pin, 0);
+    dma_channel_transfer_to_buffer_now(rx_chan, &rx_bytes[entry * ENTRY_BYTES], status ? STATUS_BYTES : ENTRY_BYTES);
+    dma_channel_transfer_from_buffer_now(tx_chan, status ? spi_status_cmd : spi_cmd, status ? STATUS_BYTES : ENTRY_BYTES);
+}
+
+
+// reads FIFO_STATUS, for how many entries there are to read
+static void start_batch()
+{
+    i2c_hw_t *hw;
+
+    state = SAMPLER_COUNTING;
+    start_us = time_us_32();
+    deadline_us = time_us_64() + ADX_SAMPLER_TIMEOUT_US;
+    set_alarm(deadline_us);
+
+    if (acc->bus == ADXL343_BUS_SPI) {
+        gpio_put(acc->cs_pin, 0);
+        dma_channel_transfer_to_buffer_now(rx_chan, count_rx, STATUS_BYTES);
+        dma_channel_transfer_from_buffer_now(tx_chan, spi_count_cmd, STATUS_BYTES);
+        return;
+    }
+
+    // clear an abort left over from a transfer that timed out, which would hold the command FIFO up
+    hw = i2c_get_hw(acc->i2c);
+    (void)hw->clr_tx_abrt;
+    dma_channel_transfer_to_buffer_now(rx_chan, count_rx, STATUS_BYTES - 1);
+    dma_channel_transfer_from_buffer_now(tx_chan, i2c_count_cmds, STATUS_BYTES);
+}
+
+
+// reads the read_n entries FIFO_STATUS counted, and INT_SOURCE, under the deadline start_batch set
+static void read_entries()
+{
+    state = SAMPLER_READING;
+    if (acc->bus == ADXL343_BUS_SPI) {
+        entry = 0;
+        spi_start_entry();
+        return;
+    }
+
+    dma_channel_transfer_to_buffer_now(rx_chan, rx_bytes, read_n * (ENTRY_BYTES - 1) + STATUS_BYTES - 1);
+    dma_channel_transfer_from_buffer_now(tx_chan, &i2c_cmds[(ADXL3XX_FIFO_SIZE - read_n) * ENTRY_BYTES],
+                                         read_n * ENTRY_BYTES + STATUS_BYTES);
+}
+
+
+// aborts both channels without the abort raising their interrupt (RP2040-E13)
+static void abort_dma()
+{
+    dma_channel_set_irq0_enabled(rx_chan, false);
+    dma_channel_abort(rx_chan);
+    dma_channel_abort(tx_chan);
+    dma_channel_acknowledge_irq0(rx_chan);
+    dma_channel_set_irq0_enabled(rx_chan, true);
+}
+
+
+static void abort_transfer()
+{
+    i2c_hw_t *hw;
+
+    abort_dma();
+    if (acc->bus == ADXL343_BUS_SPI) {
+        gpio_put(acc->cs_pin, 1);
+        while (spi_is_readable(acc->spi))
+            (void)spi_get_hw(acc->spi)->dr;
+        return;
+    }
+
+    // the i2c flushes its command FIFO and lets go of the bus in the background, and drops what it had read
+    hw = i2c_get_hw(acc->i2c);
+    hw->enable |= I2C_IC_ENABLE_ABORT_BITS;
+    while (hw->rxflr > 0)
+        (void)hw->data_cmd;
+}
+
+
+// starts the batch that is waiting, if there is one, and otherwise watches for a stall, or polls again a batch later
+static void next_batch()
+{
+    // sampler_stop is waiting for the bus
+    if (stopping) {
+        state = SAMPLER_STOPPED;
+        __sev();
+        return;
+    }
+
+    // WATERMARK is level triggered, so a FIFO that filled up again while the last batch was read has no edge
+    if (batch_waiting || (int1 != SAMPLER_NO_PIN && gpio_get(int1))) {
+        batch_waiting = false;
+        start_batch();
+        return;
+    }
+
+    state = SAMPLER_IDLE;
+    set_alarm(time_us_64() + (uint64_t)(int1 == SAMPLER_NO_PIN ? 1 : ADX_SAMPLER_STALL_BATCHES) * batch_n * period_us);
+}
+
+
+static void sampler_alarm(uint alarm)
+{
+    (void)alarm;
+
+    switch (state) {
+        case SAMPLER_POPPING:
+            state = SAMPLER_READING;
+            spi_start_entry();
+            set_alarm(deadline_us);
+            break;
+        case SAMPLER_COUNTING:
+        case SAMPLER_READING:
+            // entries the aborted transfer popped are lost
+            abort_transfer();
+            resync = true;
+            sampler_stats.timeouts++;
+            TRACE(TRACE_SAMPLER_TIMEOUT, acc->bus == ADXL343_BUS_SPI && state == SAMPLER_READING ? entry : 0,
+                  time_us_32() - start_us);
+            next_batch();
+            break;
+        default:
+            // time to poll, or an edge was missed or the sensor has stopped. FIFO_STATUS says how much it has
+            // collected meanwhile
+            if (int1 != SAMPLER_NO_PIN) {
+                sampler_stats.stalls++;
+                TRACE(TRACE_SAMPLER_STALL, gpio_get(int1), 0);
+            }
+            start_batch();
+            break;
+    }
+}
+
+
+static void set_alarm(uint64_t t_us)
+{
+    // a time that has already passed runs the alarm's work straight away
+    if (hardware_alarm_set_target(alarm_num, from_us_since_boot(t_us)))
+        sampler_alarm(alarm_num);
+}
+
+
+static void sampler_dma_irq()
+{
+    if (!dma_channel_get_irq0_status(rx_chan))
+        return;
+    dma_channel_acknowledge_irq0(rx_chan);
+
+    if (acc->bus == ADXL343_BUS_SPI)
+        gpio_put(acc->cs_pin, 1);
+
+    // the batch is every entry the FIFO holds, however many came in since the WATERMARK. An empty one still has
+    // INT_SOURCE read, which may be what is holding the pin up
+    if (state == SAMPLER_COUNTING) {
+        status_us = time_us_64();
+        read_n = count_rx[acc->bus == ADXL343_BUS_SPI ? 1 : 0] & 0x3f;
+        if (read_n > ADXL3XX_FIFO_SIZE)
+            read_n = ADXL3XX_FIFO_SIZE;
+        // a poll a batch after the last one should never find the FIFO empty
+        if (read_n == 0 && int1 == SAMPLER_NO_PIN) {
+            sampler_stats.stalls++;
+            TRACE(TRACE_SAMPLER_STALL, 0, 0);
+        }
+        read_entries();
+        return;
+    }
+
+    // ending the burst pops the entry, which has to be done before the next one is read
+    if (acc->bus == ADXL343_BUS_SPI) {
+        if (++entry <= read_n) {
+            state = SAMPLER_POPPING;
+            set_alarm(time_us_64() + ADXL343_FIFO_POP_US);
+            return;
+        }
+        batch_done(ENTRY_BYTES, 1, rx_bytes[read_n * ENTRY_BYTES + 1]);
+    }
+    else {
+        batch_done(ENTRY_BYTES - 1, 0, rx_bytes[read_n * (ENTRY_BYTES - 1)]);
+    }
+
+    // core 0 may be sleeping until samples arrive
+    __sev();
+    next_batch();
+}
+
+
+static void setup_dma()
+{
+    dma_channel_config c;
+    volatile void *data;
+    uint rx_dreq, tx_dreq;
+    uint i, j;
+
+    if (acc->bus == ADXL343_BUS_SPI) {
+        data = &spi_get_hw(acc->spi)->dr;
+        rx_dreq = spi_get_dreq(acc->spi, false);
+        tx_dreq = spi_get_dreq(acc->spi, true);
+    }
+    else {
+        i2c_hw_t *hw = i2c_get_hw(acc->i2c);
+
+        // the command FIFO is fed straight from memory, so the target address has to be set up front
+        hw->enable = 0;
+        hw->tar = acc->address;
+        hw->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS | I2C_IC_DMA_CR_RDMAE_BITS;
+        hw->enable = 1;
+        data = &hw->data_cmd;
+        rx_dreq = i2c_get_dreq(acc->i2c, false);
+        tx_dreq = i2c_get_dreq(acc->i2c, true);
+
+        // each entry is its own read of DATAX0 through DATAZ1, ended with a stop so the FIFO pops
+        for (i = 0; i < ADXL3XX_FIFO_SIZE; i++) {
+            uint32_t *cmds = &i2c_cmds[i * ENTRY_BYTES];
+
+            cmds[0] = ADXL3XX_REG_DATAX0;
+            for (j = 1; j < ENTRY_BYTES; j++)
+                cmds[j] = I2C_IC_DATA_CMD_CMD_BITS;
+            cmds[1] |= I2C_IC_DATA_CMD_RESTART_BITS;
+            cmds[ENTRY_BYTES - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+        }
+        i2c_cmds[ADXL3XX_FIFO_SIZE * ENTRY_BYTES] = ADXL3XX_REG_INT_SOURCE;
+        i2c_cmds[ADXL3XX_FIFO_SIZE * ENTRY_BYTES + 1] = I2C_IC_DATA_CMD_CMD_BITS | I2C_IC_DATA_CMD_RESTART_BITS |
+                                                        I2C_IC_DATA_CMD_STOP_BITS;
+        i2c_count_cmds[0] = ADXL3XX_REG_FIFO_STATUS;
+        i2c_count_cmds[1] = i2c_cmds[ADXL3XX_FIFO_SIZE * ENTRY_BYTES + 1];
+    }
+
+    rx_chan = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(rx_chan);
+    channel_config_set_transfer_data_size(&c, DMA_SIZE_8);
+    channel_config_set_read_increment(&c, false);
+    channel_config_set_write_increment(&c, true);
+    channel_config_set_dreq(&c, rx_dreq);
+    dma_channel_configure(rx_chan, &c, rx_bytes, data, 0, false);
+
+    // the i2c takes a command and its flags in one write, SPI a byte at a time
+    tx_chan = dma_claim_unused_channel(true);
+    c = dma_channel_get_default_config(tx_chan);
+    channel_config_set_transfer_data_size(&c, acc->bus == ADXL343_BUS_SPI ? DMA_SIZE_8 : DMA_SIZE_32);
+    channel_config_set_read_increment(&c, true);
+    channel_config_set_write_increment(&c, false);
+    channel_config_set_dreq(&c, tx_dreq);
+    dma_channel_configure(tx_chan, &c, data, NULL, 0, false);
+
+    dma_channel_set_irq0_enabled(rx_chan, true);
+    irq_set_exclusive_handler(DMA_IRQ_0, sampler_dma_irq);
+    irq_set_enabled(DMA_IRQ_0, true);
+
+    alarm_num = hardware_alarm_claim_unused(true);
+    hardware_alarm_set_callback(alarm_num, sampler_alarm);
+}
+#endif
+
+
+int sampler_init(adxl343 *accelerometer, uint int1_pin, uint watermark, uint32_t sample_period_us)
+{
+    if (watermark == 0 || watermark > ADXL3XX_FIFO_SAMPLES_MAX)
+        return PICO_ERROR_GENERIC;
+
+    acc = accelerometer;
+    int1 = int1_pin;
+    batch_n = watermark;
+    period_us = sample_period_us;
+    ring_head = 0;
+    ring_tail = 0;
+    int_source = 0;
+    last_us = 0;
+    memset((void *)&sampler_stats, 0, sizeof(sampler_stats));
+
+#ifndef LIGHT_WAND_HOST
+    if (acc->bus != ADXL343_BUS_MOCK)
+        setup_dma();
+#endif
+    sampler_start();
+    return PICO_ERROR_NONE;
+}
+
+
+void sampler_stop()
+{
+    uint32_t irq_state = save_and_disable_interrupts();
+
+    // a transfer in progress is left to finish or time out, and stops the sampler when it does
+    stopping = true;
+    if (state == SAMPLER_IDLE) {
+#ifndef LIGHT_WAND_HOST
+        if (acc->bus != ADXL343_BUS_MOCK)
+            hardware_alarm_cancel(alarm_num);
+#endif
+        state = SAMPLER_STOPPED;
+    }
+    restore_interrupts(irq_state);
+
+    while (state != SAMPLER_STOPPED)
+        __wfe();
+}
+
+
+void sampler_start()
+{
+    stopping = false;
+    batch_waiting = false;
+    resync = true;
+    state = SAMPLER_IDLE;
+
+#ifndef LIGHT_WAND_HOST
+    // the FIFO may have filled up since it was set up, with no edge to come
+    if (acc->bus != ADXL343_BUS_MOCK)
+        next_batch();
+#endif
+}
+
+
+uint8_t sampler_int_source()
+{
+    uint32_t irq_state = save_and_disable_interrupts();
+    uint8_t source = int_source;
+
+    int_source = 0;
+    restore_interrupts(irq_state);
+    return source;
+}
+
+
+void sampler_watermark()
+{
+    uint8_t entries, source;
+    uint i;
+
+    if (state == SAMPLER_STOPPED)
+        return;
+
+    // nothing to wait for from the mock, the batch is there to be read
+    if (acc->bus == ADXL343_BUS_MOCK) {
+        start_us = time_us_32();
+        if (adxl343_get_fifo_status(acc, &entries, NULL) < 0)
+            return;
+        status_us = time_us_64();
+        read_n = entries;
+        for (i = 0; i < read_n; i++) {
+            if (adxl343_read_registers(acc, ADXL3XX_REG_DATAX0, &rx_bytes[i * ENTRY_BYTES], ENTRY_BYTES - 1) < 0)
+                return;
+        }
+        if (adxl343_get_int_source(acc, &source) < 0)
+            return;
+        batch_done(ENTRY_BYTES, 0, source);
+        return;
+    }
+
+#ifndef LIGHT_WAND_HOST
+    if (state != SAMPLER_IDLE) {
+        batch_waiting = true;
+        return;
+    }
+    hardware_alarm_cancel(alarm_num);
+    start_batch();
+#endif
+}
+
+
+bool sampler_available()
+{
+    return ring_head != ring_tail;
+}
+
+
+bool sampler_pop(sampler_entry *out)
+{
+    uint32_t tail = ring_tail;
+
+    if (ring_head == tail)
+        return false;
+
+    // the sample must not be read before the head that published it, and must be read before its slot is reused
+    __dmb();
+    *out = ring[tail % ADX_SAMPLER_RING_SIZE];
+    __dmb();
+    ring_tail = tail + 1;
+    return true;
+}
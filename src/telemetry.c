@@ -0,0 +1,98 @@
+#include "pico/stdlib.h"
+
+#include "telemetry.h"
+
+
+static void put_16(uint8_t *buf, uint16_t val)
+{
+    buf[0] = (uint8_t)val;
+    buf[1] = (uint8_t)(val >> 8);
+}
+
+
+static void put_64(uint8_t *buf, uint64_t val)
+{
+    int i;
+
+    for (i = 0; i < 8; i++)
+        buf[i] = (uint8_t)(val >> (8 * i));
+}
+
+
+void telemetry_init(telemetry_packet *packet)
+{
+    packet->seq = 0;
+    packet->n_samples = 0;
+    packet->flags = 0;
+    packet->prev_us = 0;
+}
+
+
+int telemetry_add_sample(telemetry_packet *packet, uint64_t t_us, const adxl343_xyz *sample)
+{
+    uint8_t *p;
+    uint64_t dt_us = 0;
+
+    if (packet->n_samples == TELEMETRY_MAX_SAMPLES)
+        return -1;
+
+    // the first sample carries the full timestamp in the header, the rest are deltas
+    if (packet->n_samples == 0) {
+        put_64(&packet->buf[7], t_us);
+    }
+    else {
+        dt_us = t_us >= packet->prev_us ? t_us - packet->prev_us : 0;
+        if (dt_us > UINT16_MAX)
+            return -1;
+    }
+
+    p = &packet->buf[TELEMETRY_HEADER_LEN + packet->n_samples * TELEMETRY_SAMPLE_LEN];
+    put_16(&p[0], (uint16_t)dt_us);
+    put_16(&p[2], (uint16_t)sample->x);
+    put_16(&p[4], (uint16_t)sample->y);
+    put_16(&p[6], (uint16_t)sample->z);
+
+    packet->n_samples++;
+    packet->prev_us = t_us;
+    return 0;
+}
+
+
+void telemetry_set_flags(telemetry_packet *packet, uint8_t flags)
+{
+    packet->flags |= flags;
+}
+
+
+size_t telemetry_finish(telemetry_packet *packet, const uint8_t **out)
+{
+    size_t i, len;
+    uint16_t sum1 = 0, sum2 = 0;
+
+    if (packet->n_samples == 0)
+        return 0;
+
+    packet->buf[0] = TELEMETRY_SYNC0;
+    packet->buf[1] = TELEMETRY_SYNC1;
+    packet->buf[2] = TELEMETRY_VERSION;
+    packet->buf[3] = packet->flags;
+    put_16(&packet->buf[4], packet->seq);
+    packet->buf[6] = packet->n_samples;
+
+    // Fletcher-16 over everything after the sync bytes
+    len = TELEMETRY_HEADER_LEN + packet->n_samples * TELEMETRY_SAMPLE_LEN;
+    for (i = 2; i < len; i++) {
+        sum1 = (sum1 + packet->buf[i]) % 255;
+        sum2 = (sum2 + sum1) % 255;
+    }
+    packet->buf[len] = (uint8_t)sum1;
+    packet->buf[len + 1] = (uint8_t)sum2;
+
+    // the next sample starts the next packet
+    packet->seq++;
+    packet->n_samples = 0;
+    packet->flags = 0;
+
+    *out = packet->buf;
+    return len + TELEMETRY_CHECKSUM_LEN;
+}
@@ -0,0 +1,126 @@
+#include <stdio.h>
+
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#include "trace.h"
+
+trace_ring trace_rings[2];
+
+static const char *const trace_type_names[TRACE_N_TYPES] = {
+    [TRACE_I2C_READ]        = "I2C_READ",
+    [TRACE_REVERSAL]        = "REVERSAL",
+    [TRACE_ANTICIPATE]      = "ANTICIPATE",
+    [TRACE_SWING_DROP]      = "SWING_DROP",
+    [TRACE_DOORBELL_SKIP]   = "DOORBELL_SKIP",
+    [TRACE_SWING_START]     = "SWING_START",
+    [TRACE_SWING_END]       = "SWING_END",
+    [TRACE_COLUMN_LATE]     = "COLUMN_LATE",
+    [TRACE_COLUMN_SKIP]     = "COLUMN_SKIP",
+    [TRACE_COLUMN_DROPPED]  = "COLUMN_DROPPED",
+    [TRACE_OVERRUN]         = "OVERRUN",
+    [TRACE_SAMPLER_TIMEOUT] = "SAMPLER_TIMEOUT",
+    [TRACE_SAMPLER_STALL]   = "SAMPLER_STALL",
+    [TRACE_IDLE]            = "IDLE",
+};
+
+
+void trace_record(trace_type type, uint16_t a, uint32_t b)
+{
+    trace_ring *ring = &trace_rings[get_core_num()];
+    trace_event *ev;
+    uint32_t head, irq_state;
+
+    // the core's interrupt handlers record into the same ring, so keep them out while the slot is claimed
+    irq_state = save_and_disable_interrupts();
+    ring->counts[type]++;
+    head = ring->head;
+    if (head - ring->tail == TRACE_RING_SIZE) {
+        ring->dropped++;
+        restore_interrupts(irq_state);
+        return;
+    }
+
+    ev = &ring->events[head % TRACE_RING_SIZE];
+    ev->t_us = time_us_32();
+    ev->type = type;
+    ev->a = a;
+    ev->b = b;
+
+    // the event must be written before the other core can see the new head
+    __dmb();
+    ring->head = head + 1;
+    restore_interrupts(irq_state);
+}
+
+
+bool trace_pop(trace_ring *ring, trace_event *out)
+{
+    uint32_t tail = ring->tail;
+
+    if (ring->head == tail)
+        return false;
+
+    // the event must not be read before the head that published it, and must be read before its slot is reused
+    __dmb();
+    *out = ring->events[tail % TRACE_RING_SIZE];
+    __dmb();
+    ring->tail = tail + 1;
+    return true;
+}
+
+
+const char *trace_type_name(trace_type type)
+{
+    return type < TRACE_N_TYPES ? trace_type_names[type] : "?";
+}
+
+
+uint32_t trace_count(int core, trace_type type)
+{
+    return trace_rings[core].counts[type] - trace_rings[core].counts_base[type];
+}
+
+
+void trace_clear()
+{
+    int core, i;
+
+    for (core = 0; core < 2; core++) {
+        trace_ring *ring = &trace_rings[core];
+
+        // only the consumer's end moves, so a core recording at the same time is never disturbed. Zeroing its
+        // counters could lose an increment made in between, so they are counted on from where they are instead
+        ring->tail = ring->head;
+        ring->dropped_base = ring->dropped;
+        for (i = 0; i < TRACE_N_TYPES; i++)
+            ring->counts_base[i] = ring->counts[i];
+    }
+}
+
+
+void trace_dump_events()
+{
+    trace_event ev;
+    int core;
+
+    // the rings are drained one after the other, the timestamps put the two cores back in order
+    for (core = 0; core < 2; core++) {
+        while (trace_pop(&trace_rings[core], &ev))
+            printf("EV %d %u %s %u %u\n", core, (unsigned)ev.t_us, trace_type_name(ev.type), ev.a, (unsigned)ev.b);
+    }
+}
+
+
+void trace_dump()
+{
+    int core, i;
+
+    for (core = 0; core < 2; core++) {
+        for (i = 0; i < TRACE_N_TYPES; i++)
+            printf("COUNT %d %s %u\n", core, trace_type_names[i], (unsigned)trace_count(core, i));
+        printf("DROPPED %d %u\n", core, (unsigned)(trace_rings[core].dropped - trace_rings[core].dropped_base));
+    }
+
+    trace_dump_events();
+}